@@ -42,6 +42,9 @@ int AABB_vs_AABB(AABB *a, AABB *b);
 
 int AABB_vs_Point(AABB *a, float x, float y);
 
+SDL_Rect AABB_toRect(AABB *a);
+
 void AABB_renderColor(AABB *a, SDL_Color c);
+void AABB_renderRects(const SDL_Rect *rects, const SDL_Color *colors, int count);
 
 #endif //DUMMY_AABB_H
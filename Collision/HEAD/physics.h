@@ -41,6 +41,35 @@
  * HYBRID vs STATIC
  * HYBRID vs HYBRID
  *
+ * As a by-product of the collision detection each DYNAMIC and HYBRID object gets its PH_Contacts filled, these tell
+ * which sides of the object touch solid geometry after the last world step, so game code does not have to query
+ * the world for it.
+ *
+ * PH_stepWorld() chunks the time it is given into steps of the World's stepTime, a step function set with
+ * PH_setStepFunc() is called before each of them with the time the step ends at, so input which has happened
+ * during the delta can be applied at the step it belongs to, instead of all of it before the first one.
+ *
+ * Collisions between kinds of objects can be handled by pair handlers, registered per World for a pair of
+ * UserDataTypes with PH_setPairHandler(). Overlapping pairs with a handler are never resolved, their manifolds are
+ * collected during the step and each handler is called once per step with all of the contacts of its pair, in the
+ * order the handlers were registered. Per object callbacks (PH_setCallback()) are only consulted for pairs without one.
+ *
+ * Big worlds can be divided into a grid of chunks with PH_setChunks(). Then only the chunks around activator objects
+ * (see PH_setActivator()) are simulated every step, the rest are dormant: frozen, or stepped at a reduced rate.
+ * Objects in chunks which are not stepped are neither moved, nor tested for collisions, so the cost of a step depends
+ * on the active area, not on the size of the world.
+ *
+ * Large amounts of static geometry should be added as tiles with PH_addTile() instead of static objects. A tile is
+ * only an integer rectangle and a type, stored in a compact array indexed by a grid. Tiles push dynamic objects out
+ * like static objects do. With anything else they only interact through pair handlers, the tile's type acts as its
+ * UserDataType. In the manifolds the Object pointer on the tile's side is NULL, the tile is set instead.
+ *
+ * A World created with PH_createWorldIn() takes all of its memory from an Arena, destroyed objects are recycled for
+ * the next ones, and the whole World is released by resetting the arena, PH_destroyWorld() is then a no-op.
+ *
+ * Anything outliving a frame, or not sure whether the object it refers to still exists, should keep the object's
+ * generational Handle (PH_getHandle()) instead of the pointer, PH_getObject() returns NULL once the object is destroyed.
+ *
  */
 #ifndef DUMMY_PHYSICS_H
 #define DUMMY_PHYSICS_H
@@ -48,6 +77,9 @@
 #include <stdint.h>
 #include "../../Utility/HEAD/vector.h"
 #include "../../Utility/HEAD/bag.h"
+#include "../../Utility/HEAD/array.h"
+#include "../../Utility/HEAD/arena.h"
+#include "../../Utility/HEAD/handle.h"
 #include "AABB.h"
 
 /**
@@ -79,12 +111,43 @@ typedef struct Object Object;
  *      DYNAMIC vs STATIC
  *      HYBRID vs STATIC
  *      HYBRID vs HYBRID
+ *      TILE vs DYNAMIC
+ *      TILE vs HYBRID
  */
 typedef enum PH_COLL_TYPE PH_COLL_TYPE;
 /**
  * @brief Holds data about a collision, used be the collision resolution function.
  */
 typedef struct PH_Manifold PH_Manifold;
+/**
+ * @brief Identifies a side of an object, used to index PH_Contacts.
+ */
+typedef enum PH_SIDE PH_SIDE;
+/**
+ * @brief Holds which sides of an object are touching other objects, filled during PH_stepWorld().
+ */
+typedef struct PH_Contacts PH_Contacts;
+/**
+ * @brief Contacts of a pair of UserDataTypes collected during a step, along with the handler they are passed to.
+ */
+typedef struct PH_ContactBatch PH_ContactBatch;
+/**
+ * @brief A cell of the World's chunk grid, indexes the objects in it.
+ */
+typedef struct PH_Chunk PH_Chunk;
+/**
+ * @brief A piece of static geometry, see PH_addTile().
+ */
+typedef struct PH_Tile PH_Tile;
+
+/**
+ * @brief The object lists of a World, pointers so the objects stay in place.
+ */
+DEFINE_ARRAY(Object*, ObjectArray)
+/**
+ * @brief The chunks stepped in a world step.
+ */
+DEFINE_ARRAY(PH_Chunk*, PH_ChunkRefArray)
 
 /**
  * @brief Objects can have collision callbacks set to them, they have to adhere to this signature.
@@ -95,6 +158,25 @@ typedef struct PH_Manifold PH_Manifold;
  */
 typedef int (*PH_callback)(PH_Manifold *m, Object *callObj, Object *collObj,  void *state);
 
+/**
+ * @brief Pair handlers registered with PH_setPairHandler() have to adhere to this signature.
+ *
+ * Called once per world step with every contact of the pair during that step. In each manifold A has the first and B
+ * has the second UserDataType of the registration, the normal points from A to B. The objects may not be destroyed
+ * during the call, the same object can appear in later contacts. The last argument is the state pointer set at
+ * registration.
+ */
+typedef void (*PH_pairHandler)(PH_Manifold *contacts, int count, void *state);
+
+/**
+ * @brief Step functions registered with PH_setStepFunc() have to adhere to this signature.
+ *
+ * Called before each step PH_stepWorld() takes, time is the time in seconds from the start of the delta passed to
+ * PH_stepWorld() to the end of the step, so anything which has happened before it can be applied to the world first.
+ * The last argument is the state pointer set at registration.
+ */
+typedef void (*PH_stepFunc)(World *world, double time, void *state);
+
 /**
  * @brief Each object can have a void* userData and a userDataType bind data to objects.
  */
@@ -110,7 +192,9 @@ typedef enum UserDataType {
     /**@brief Attackbox spawned when a player attacks, used for collision callbacks.*/
     ATTACKBOX,
     /**@brief Bullet object spawned when the player shoots, used for collision callbacks.*/
-    BULLET
+    BULLET,
+    /**@brief The number of user data types, not a valid type.*/
+    USER_DATA_TYPE_TOTAL
 } UserDataType;
 
 /**
@@ -122,25 +206,108 @@ typedef struct UserData {
 } UserData;
 
 typedef struct World {
-    Bag *dynObjBag; //bag for dynamic objects
-    Bag *stObjBag; //bag for static objects
-    Bag *hybObjBag; //bag for hybrid objects
+    ObjectArray dynObjs; //the dynamic objects
+    ObjectArray stObjs; //the static objects
+    ObjectArray hybObjs; //the hybrid objects
     Vector2D gravity; //the gravity vector
     double stepTime; //the length of a single world step
     double deltaLeftover; //the remaining time which "has to be stepped yet"
+    PH_stepFunc stepFunc; //called before each step, or NULL
+    void *stepState; //passed to stepFunc
+
+    PH_ContactBatch *pairTable[USER_DATA_TYPE_TOTAL][USER_DATA_TYPE_TOTAL]; //handled pairs by user data types, or NULL
+    uint8_t pairSwap[USER_DATA_TYPE_TOTAL][USER_DATA_TYPE_TOTAL]; //non-zero if the pair is registered the other way
+    Bag *pairBatches; //the PH_ContactBatches in registration order
+
+    PH_Chunk *chunks; //the chunk grid in row major order, NULL if the world is not chunked
+    float chunkSize; //the width and height of a chunk
+    int chunkCols; //number of chunks along the x axis
+    int chunkRows; //number of chunks along the y axis
+    int activeRadius; //chunks this close to an activator's chunks are stepped every time
+    int dormantInterval; //dormant chunks are stepped every this many steps, 0 freezes them
+    uint32_t stepCount; //the number of steps taken, used to tell the chunks active in the current step
+    uint32_t stamp; //incremented to visit each chunk and object once while gathering them
+    ObjectArray activators; //objects keeping the chunks around them active
+    PH_ChunkRefArray stepChunks; //the chunks stepped in the current step
+    PH_ChunkRefArray forceChunks; //the chunks whose objects' forces are reset at the end of PH_stepWorld()
+    ObjectArray stepDyn; //dynamic objects stepped in the current step
+    ObjectArray nearHyb; //hybrid objects around the stepped objects
+    ObjectArray nearSt; //static objects around the stepped objects
+
+    PH_Tile *tiles; //the tiles of the world
+    int tileCount; //number of tiles
+    int tileMaxSize; //the size of the tiles array
+    int tileDirty; //non-zero if tiles were added since the grid was built
+    int tileOrigin[2]; //the bottom left corner of the tile grid
+    int tileCols; //number of cells in the tile grid along the x axis
+    int tileRows; //number of cells in the tile grid along the y axis
+    int *tileCellStart; //the first index in tileCellItems for each cell, plus one past the end, tileCols * tileRows + 1
+    int *tileCellItems; //the tile indices stored by cell, a tile is stored in each cell it overlaps
+    SDL_Color tileColors[USER_DATA_TYPE_TOTAL]; //the colour tiles are rendered with by type
+
+    Arena *arena; //where everything of the world is allocated, NULL for the heap
+    ObjectArray freeObjs; //destroyed objects of an arena world, reused by the next objects created
+    HandleTable handles; //the handles of the objects
 } World;
 
+typedef struct PH_Chunk {
+    /**@brief Dynamic and hybrid objects with their center in this chunk.*/
+    ObjectArray home;
+    /**@brief Static and hybrid objects overlapping this chunk.*/
+    ObjectArray overlap;
+    /**@brief The last World stamp which visited this chunk.*/
+    uint32_t stamp;
+    /**@brief The last step this chunk was stepped in.*/
+    uint32_t activeStep;
+    /**@brief The time the chunk's objects were stepped by during its last step.*/
+    double stepDelta;
+    /**@brief Whether the chunk is in World.forceChunks.*/
+    int forceReset;
+} PH_Chunk;
+
+typedef struct PH_Tile {
+    /**@brief The bottom left corner.*/
+    int16_t min[2];
+    /**@brief The top right corner.*/
+    int16_t max[2];
+    /**@brief The UserDataType of the tile.*/
+    uint8_t type;
+} PH_Tile;
+
 typedef enum PH_OBJ_TYPE {
     STATIC = 1,
     HYBRID = 2,
     DYNAMIC = 4
 } PH_OBJ_TYPE;
 
+typedef enum PH_SIDE {
+    PH_LEFT,
+    PH_RIGHT,
+    PH_TOP,
+    PH_BOTTOM,
+    PH_SIDE_TOTAL
+} PH_SIDE;
+
+/**@brief Converts a PH_SIDE to the bit used in PH_Contacts.flags.*/
+#define PH_CONTACT(side) (1u << (side))
+
+/**@brief The number of overlapped chunks an object keeps its index in, an object smaller than a chunk overlaps 4.*/
+#define PH_OVERLAP_HANDLES (4)
+
+typedef struct PH_Contacts {
+    /**@brief PH_CONTACT() bits OR'd together, one for each side touching something.*/
+    uint32_t flags;
+    /**@brief The object touching a given side, NULL for tiles, only valid until the next object is destroyed.*/
+    Object *with[PH_SIDE_TOTAL];
+} PH_Contacts;
+
 typedef struct Object {
     /**@brief The world this object belongs to.*/
     World *world;
     /**@brief Do not modify, index at which this object is stored in the World.*/
     int oHandle;
+    /**@brief Do not modify, the generational handle of the object, see PH_getHandle().*/
+    Handle handle;
 
     PH_OBJ_TYPE type;
 
@@ -153,10 +320,27 @@ typedef struct Object {
     float velCapY;
 
     float invMass;
+    /**@brief The mass the object was created with, 0 for static objects, saves a divide when applying gravity.*/
+    float mass;
     /**@brief The dimension of the object*/
     AABB aabb;
     /**@brief Position of the object before the last position integration.*/
     Vector2D lastPos;
+    /**@brief Sides touching solid objects during the last world step, only maintained for DYNAMIC and HYBRID objects.*/
+    PH_Contacts contacts;
+
+    /**@brief Do not modify, index of the chunk the center of the object is in, -1 if the world is not chunked.*/
+    int chunk;
+    /**@brief Do not modify, index at which this object is stored in its chunk.*/
+    int chunkHandle;
+    /**@brief Do not modify, the chunks a static or hybrid object overlaps: first x, first y, last x, last y.*/
+    int chunkRange[4];
+    /**@brief Do not modify, index at which this object is stored in the overlap list of the first chunks of its range.*/
+    int overlapHandles[PH_OVERLAP_HANDLES];
+    /**@brief Do not modify, the last World stamp which visited this object.*/
+    uint32_t stamp;
+    /**@brief Do not modify, index at which this object is stored in the World's activators, -1 if it is not one.*/
+    int activatorHandle;
 
     UserData userData;
 
@@ -174,7 +358,9 @@ typedef enum PH_COLL_TYPE {
     HYBRID_HYBRID,
     STATIC_DYNAMIC,
     HYBRID_DYNAMIC,
-    DYNAMIC_DYNAMIC
+    DYNAMIC_DYNAMIC,
+    TILE_DYNAMIC,
+    TILE_HYBRID
 } PH_COLL_TYPE;
 
 
@@ -186,34 +372,60 @@ typedef struct PH_Manifold {
     Vector2D n;
     /**@brief Penetration depth.*/
     float depth;
+    /**@brief The tile taking part in the collision, NULL if both sides are objects.*/
+    const PH_Tile *tile;
 } PH_Manifold;
 
+typedef struct PH_ContactBatch {
+    PH_pairHandler handler;
+    void *state;
+    /**@brief Manifolds collected during the current step.*/
+    PH_Manifold *contacts;
+    int count;
+    int maxSize;
+    Arena *arena; //the arena of the world
+} PH_ContactBatch;
+
 
 
 World *PH_createWorld();
+World *PH_createWorldIn(Arena *arena);
+Arena *PH_getArena(World *world);
 Object *PH_createBox(int x, int y, int width, int height, float mass, PH_OBJ_TYPE type, World *world);
 void PH_setStepTime(double delta, World *world);
+void PH_setStepFunc(PH_stepFunc func, void *state, World *world);
 void PH_setGravity(float gravityX, float gravityY, World *world);
 void PH_stepWorld(double delta, World *world);
 
 
 void PH_impulse(Vector2D *impulse, Object *obj);
 void PH_force(Vector2D *force, Object *obj);
+void PH_resetForce(Object *obj, World *world);
 void PH_setVelCap(float capX, float capY, Object *obj);
 void PH_setPosition(Vector2D vec, Object *obj);
 
 void PH_setUData(void *data, UserDataType type, Object *obj);
 
 void PH_destroyObject(Object *o);
+Handle PH_getHandle(Object *obj);
+Object *PH_getObject(Handle handle, World *world);
 void PH_destroyWorld(World *world);
 
 
 void PH_setCallback(PH_callback callBack, void *state, Object *obj);
+void PH_setPairHandler(UserDataType a, UserDataType b, PH_pairHandler handler, void *state, World *world);
+
+void PH_setChunks(float chunkSize, int cols, int rows, int activeRadius, int dormantInterval, World *world);
+void PH_setActivator(int activator, Object *obj);
+
+int PH_addTile(int x, int y, int width, int height, UserDataType type, World *world);
+void PH_setTileColor(UserDataType type, Uint8 r, Uint8 g, Uint8 b, Uint8 a, World *world);
 
 void PH_queryPoint(Vector2D point, PH_OBJ_TYPE types, int cap, Bag *bag, World *world);
 
 
 
 void PH_renderObjects(World *world);
+void PH_renderTiles(World *world);
 void PH_setColor(Uint8 r, Uint8 g, Uint8 b, Uint8 a, Object *o);
 #endif //DUMMY_PHYSICS_H
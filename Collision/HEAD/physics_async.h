@@ -0,0 +1,89 @@
+/*
+* Copyright (C) 2015 Bendegúz Nagy
+* 
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+* 
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+* 
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file
+ * @brief Runs a physics World on its own thread at a fixed rate.
+ * @author Bendegúz Nagy
+ *
+ * Once a World is handed over with PH_startAsync(), it belongs to the physics thread, nothing else may touch it or its
+ * objects until PH_stopAsync() returns.
+ *
+ * The physics thread calls the registered PH_tickFunc every stepTime of the World (see PH_setStepTime()), the tick is
+ * responsible for stepping the World with PH_stepWorld() and for any game logic that has to run in sync with it. If no
+ * tick function is registered, the World is simply stepped. The time is read from the PH_clockFunc passed to
+ * PH_startAsync(), the wall clock if it is NULL. If the thread falls behind the wall clock by more than
+ * PH_ASYNC_MAX_LAG, it skips the ticks it has missed, behind a given clock it catches up with it, however far
+ * it runs ahead.
+ *
+ * Other threads can talk to the World through a lock-free command queue: PH_asyncForce(), PH_asyncImpulse() and
+ * PH_asyncCall(). Commands are executed on the physics thread before the next tick, in the order they were pushed.
+ * Only a single thread may push commands.
+ *
+ * After each tick, the render relevant state of the objects (rectangles and colours) is published through a lock-free
+ * triple buffer, which can be drawn by PH_renderAsync() while the next tick is being simulated. Tiles are drawn
+ * straight from the World, so they all have to be added before PH_startAsync().
+ */
+
+#ifndef DUMMY_PHYSICS_ASYNC_H
+#define DUMMY_PHYSICS_ASYNC_H
+
+#include <stddef.h>
+#include "physics.h"
+#include "../../Utility/HEAD/ring.h"
+
+/**
+ * @brief A World being stepped on its own thread.
+ */
+typedef struct PH_AsyncWorld PH_AsyncWorld;
+
+/**
+ * @brief Tick functions have to adhere to this signature, called on the physics thread at a fixed rate.
+ * @param world The World owned by the physics thread.
+ * @param delta The length of the tick in seconds.
+ * @param state The state pointer passed to PH_startAsync().
+ */
+typedef void (*PH_tickFunc)(World *world, double delta, void *state);
+
+/**
+ * @brief Clock functions have to adhere to this signature, called on the physics thread.
+ * @return The current time in µs.
+ */
+typedef Uint64 (*PH_clockFunc)(void);
+
+/**
+ * @brief Functions pushed with PH_asyncCall() have to adhere to this signature.
+ * @param world The World owned by the physics thread.
+ * @param data The copy of the data passed to PH_asyncCall().
+ * @param state The state pointer passed to PH_asyncCall().
+ */
+typedef void (*PH_commandFunc)(World *world, void *data, void *state);
+
+/**@brief The maximum number of bytes PH_asyncCall() can copy for the function.*/
+#define PH_CMD_DATA_SIZE (64)
+
+PH_AsyncWorld *PH_startAsync(World *world, PH_tickFunc tick, PH_clockFunc clock, void *state);
+void PH_stopAsync(PH_AsyncWorld *aw);
+SDL_threadID PH_asyncThreadID(PH_AsyncWorld *aw);
+
+int PH_asyncForce(Vector2D force, Object *obj, PH_AsyncWorld *aw);
+int PH_asyncImpulse(Vector2D impulse, Object *obj, PH_AsyncWorld *aw);
+int PH_asyncCall(PH_commandFunc func, const void *data, size_t size, void *state, PH_AsyncWorld *aw);
+
+void PH_renderAsync(PH_AsyncWorld *aw);
+
+#endif //DUMMY_PHYSICS_ASYNC_H
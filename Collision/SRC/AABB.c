@@ -55,6 +55,20 @@ int AABB_vs_Point(AABB *a, float x, float y) {
     return 0;
 }
 
+/**
+ * @brief Converts an AABB into the screen space rectangle SDL uses to define render space.
+ * @param a the AABB to be converted.
+ * @return the rectangle covered by the AABB on the screen.
+ */
+SDL_Rect AABB_toRect(AABB *a) {
+    SDL_Rect rect;
+    rect.x = a->center.x - a->hWidth;
+    rect.y = SCREEN_HEIGHT - a->center.y - a->hHeight;
+    rect.w = a->hWidth * 2;
+    rect.h = a->hHeight * 2;
+    return rect;
+}
+
 /**
  * @brief Convenience function for rendering an AABB with a given colour, relies on global gRenderer reference.
  * @param a the AABB to be drawn.
@@ -64,11 +78,28 @@ void AABB_renderColor(AABB *a, SDL_Color c) {
     //set the color of the box by setting the draw color
     SDL_SetRenderDrawColor(gRenderer, c.r, c.g, c.b, c.a);
     //setting up a rect is required because SDL uses them to define render space
-    SDL_Rect rect;
-    rect.x = a->center.x - a->hWidth;
-    rect.y = SCREEN_HEIGHT - a->center.y - a->hHeight;
-    rect.w = a->hWidth * 2;
-    rect.h = a->hHeight * 2;
+    SDL_Rect rect = AABB_toRect(a);
     //draw the rect onto gRenderer (global variable)
     SDL_RenderFillRect(gRenderer, &rect);
 }
+
+/**
+ * @brief Draws rectangles with their colours, relies on global gRenderer reference.
+ * @param rects the rectangles to be drawn, in drawing order.
+ * @param colors the colour of each rectangle.
+ * @param count the number of rectangles.
+ *
+ * Rectangles next to each other with the same colour are drawn with a single call.
+ */
+void AABB_renderRects(const SDL_Rect *rects, const SDL_Color *colors, int count) {
+    int i, run;
+
+    for(i = 0; i < count; i += run) {
+        //find the end of the run of the same colour
+        for(run = 1; i + run < count && colors[i + run].r == colors[i].r && colors[i + run].g == colors[i].g &&
+                     colors[i + run].b == colors[i].b && colors[i + run].a == colors[i].a; run++)
+            ;
+        SDL_SetRenderDrawColor(gRenderer, colors[i].r, colors[i].g, colors[i].b, colors[i].a);
+        SDL_RenderFillRects(gRenderer, &rects[i], run);
+    }
+}
@@ -16,12 +16,21 @@
 */
 
 #include <float.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
 #include "../HEAD/physics.h"
+#include "../../Utility/HEAD/frame.h"
+#include "../../Utility/HEAD/memtrack.h"
 
 /**@brief No matter how much time we pass to PH_stepWorld(), it will chunk it up into this length*/
 #define PH_DEF_STEPTIME (1.0/60.0)
 /**@brief Prevents a sprial of death*/
 #define PH_SPIRAL_OF_DEATH_CAP (0.25)
+/**@brief Objects closer than this to each other count as touching, even if they don't overlap.*/
+#define PH_CONTACT_SKIN (2.0)
+/**@brief The size of a cell in the grid indexing the tiles.*/
+#define PH_TILE_CELL_SIZE (128)
 
 
 
@@ -42,52 +51,262 @@ void PH_resetForces(World *world);
  */
 void PH_testAndResolve(World *world);
 /**
- * @brief Private, used in PH_testAndResolve(), tests two objects for collision and resolves it, call callbacks.
+ * @brief Private, used by the pair kernels, tests by overlap.
  */
-void PH_testTwoObjects(Object *A, Object *B, PH_COLL_TYPE type, PH_Manifold *m);
+static inline int PH_testOverlap(Object *A, Object *B);
 /**
- * @brief Private, used in PH_testTwoObjects(), tests by overlap.
+ * @brief Private, used by the pair kernels, generates collision manifold.
  */
-int PH_testOverlap(Object *A, Object *B);
+void PH_generateManifold(Object *objA, Object *objB, PH_COLL_TYPE type, PH_Manifold *manifold);
 /**
- * @brief Private, used in Ph_testTwoObjects(), generates collision manifold.
+ * @brief Private, fills the normal and the depth of a manifold for two overlapping AABBs.
  */
-void PH_generateManifold(Object *objA, Object *objB, PH_COLL_TYPE type, PH_Manifold *manifold);
+void PH_aabbManifold(AABB *A, AABB *B, PH_Manifold *manifold);
 /**
- * @brief Private, used in PH_testTwoObjects(), return whether the callbacks allow for collision, if they don't exit then they allow.
+ * @brief Private, used by the pair kernels, return whether the callbacks allow for collision, if they don't exit then they allow.
  */
 int PH_testCallback(Object *A, Object *B, PH_Manifold *m);
 /**
- * @brief Private, used in PH_testTwoObjects(), resolves overlap for DYNAMIC vs DYNAMIC, does nothing for anything else.
+ * @brief Private, used by the pair kernels, resolves overlap by pushing the dynamic object B out of A.
+ */
+static inline void PH_resolveCollision(PH_Manifold *m);
+/**
+ * @brief Private, used by the pair kernels, generates a manifold if the objects are within PH_CONTACT_SKIN of each other.
+ */
+int PH_testProximity(Object *objA, Object *objB, PH_COLL_TYPE type, PH_Manifold *manifold);
+/**
+ * @brief Private, fills the normal and the depth of a manifold if two AABBs are within PH_CONTACT_SKIN of each other.
+ */
+int PH_aabbProximity(AABB *A, AABB *B, PH_Manifold *manifold);
+/**
+ * @brief Private, used by the pair kernels, saves the touching sides described by the manifold into the objects' contacts.
+ */
+void PH_recordContact(PH_Manifold *m);
+/**
+ * @brief Private, called from PH_stepWorld(), clears the contacts of the dynamic and hybrid objects.
+ */
+void PH_clearContacts(World *world);
+/**
+ * @brief Private, used by the pair kernels, appends a manifold to the batch of its pair, in the registered order.
+ */
+void PH_queueContact(PH_Manifold *m, int swap, PH_ContactBatch *batch);
+/**
+ * @brief Private, called from PH_stepWorld(), passes the collected contacts to the pair handlers.
+ */
+void PH_dispatchContacts(World *world);
+/**
+ * @brief Private, freeData function for the World's PH_ContactBatches.
+ */
+void PH_freeBatch(PH_ContactBatch *batch);
+/**
+ * @brief Private, calculates the range of chunks an AABB grown by margin overlaps, clamped to the grid.
+ */
+void PH_chunkRange(AABB *a, float margin, World *world, int range[4]);
+/**
+ * @brief Private, returns the index of the chunk a point is in, clamped to the grid.
+ */
+int PH_chunkIndex(Vector2D *point, World *world);
+/**
+ * @brief Private, stores a new object in the chunks, does nothing if the world is not chunked.
+ */
+void PH_chunkInsert(Object *o);
+/**
+ * @brief Private, removes an object from the chunks, does nothing if the world is not chunked.
+ */
+void PH_chunkRemove(Object *o);
+/**
+ * @brief Private, the position of chunk x,y in the chunk range of an object, counted row by row.
+ */
+int PH_overlapIndex(Object *o, int x, int y);
+/**
+ * @brief Private, moves an object to the chunks it is in after it has moved, does nothing if the world is not chunked.
+ */
+void PH_chunkUpdate(Object *o);
+/**
+ * @brief Private, called from PH_stepWorld() in chunked worlds, collects the chunks to be stepped.
+ */
+void PH_updateActivity(World *world);
+/**
+ * @brief Private, called from PH_stepWorld() in chunked worlds, clears the contacts and integrates the objects of the
+ * stepped chunks.
+ */
+void PH_integrateChunks(World *world);
+/**
+ * @brief Private, called from PH_integrateChunks(), marks a chunk for PH_resetChunkForces().
+ */
+void PH_queueForceReset(PH_Chunk *chunk, World *world);
+/**
+ * @brief Private, called from PH_stepWorld() in chunked worlds, resets the forces of the objects in the chunks stepped
+ * since the last reset.
+ */
+void PH_resetChunkForces(World *world);
+/**
+ * @brief Private, called from PH_stepWorld() in chunked worlds, runs the pair kernels on the objects around the stepped
+ * chunks.
+ */
+void PH_testAndResolveChunks(World *world);
+/**
+ * @brief Private, qsort comparator, orders objects by their oHandle.
+ */
+int PH_compareHandles(const void *a, const void *b);
+/**
+ * @brief Private, called from PH_stepWorld(), builds the grid indexing the tiles.
  */
-void PH_resolveCollision(PH_Manifold *m);
+void PH_buildTiles(World *world);
+/**
+ * @brief Private, converts a tile to an AABB.
+ */
+static inline void PH_tileAABB(const PH_Tile *t, AABB *a);
+/**
+ * @brief Private, tests the objects against the tiles around them.
+ */
+void PH_testTiles(Object **objs, int count, World *world);
+/**
+ * @brief Private, used by PH_testTiles(), the tile equivalent of the pair kernels.
+ */
+static inline void PH_tileKernel(const PH_Tile *t, Object *B, World *world, PH_Manifold *m);
+
+/**
+ * @brief Table of the collision pair types and whether collisions between them are resolved.
+ *
+ * Each entry generates an inlined kernel, PH_kernel_<TYPE>() for testing a single pair and PH_testPairs_<TYPE>() for
+ * running it over two object arrays. The resolve flag is a compile time constant, so every kernel only contains the
+ * paths it needs: pair handlers, no callbacks, callbacks and no resolution. Pairs that never resolve only generate a
+ * manifold if there is a handler or a callback to pass it to.
+ */
+#define PH_PAIR_TYPES(X) \
+    /* type             resolves */ \
+    X(HYBRID_HYBRID,    0) \
+    X(STATIC_DYNAMIC,   1) \
+    X(HYBRID_DYNAMIC,   1) \
+    X(DYNAMIC_DYNAMIC,  0)
+
+/**
+ * @brief Generates the kernel and the pair loop for a pair type, see PH_PAIR_TYPES.
+ *
+ * The loop tests each outer element against each inner one, if the two arrays are the same, every pair is tested once.
+ */
+#define PH_DEFINE_PAIR_TYPE(TYPE, RESOLVES) \
+static inline void PH_kernel_##TYPE(Object *A, Object *B, World *world, PH_Manifold *m) { \
+    UserDataType tA = A->userData.type, tB = B->userData.type; \
+    if(!PH_testOverlap(A, B)) { \
+        /*objects without a callback or handler always allow the collision, so being next to them is touching them*/ \
+        if(RESOLVES && A->callBack == NULL && world->pairTable[tA][tB] == NULL && PH_testProximity(A, B, TYPE, m)) \
+            PH_recordContact(m); \
+        return; \
+    } \
+    if(world->pairTable[tA][tB] != NULL) { \
+        /*handled pairs never collide, the handler gets the contact after every pair has been tested*/ \
+        PH_generateManifold(A, B, TYPE, m); \
+        PH_queueContact(m, world->pairSwap[tA][tB], world->pairTable[tA][tB]); \
+    } else if(A->callBack == NULL && B->callBack == NULL) { \
+        /*no one to ask, the collision always happens*/ \
+        if(RESOLVES) { \
+            PH_generateManifold(A, B, TYPE, m); \
+            PH_resolveCollision(m); \
+            PH_recordContact(m); \
+        } \
+    } else { \
+        /*the callbacks might need the manifold, they decide if the collision happens*/ \
+        PH_generateManifold(A, B, TYPE, m); \
+        if(PH_testCallback(A, B, m) && RESOLVES) { \
+            PH_resolveCollision(m); \
+            PH_recordContact(m); \
+        } \
+    } \
+} \
+static void PH_testPairs_##TYPE(Object **outer, int outCount, Object **inner, int inCount, int sameArray, \
+                                World *world) { \
+    int i, j; \
+    PH_Manifold m; \
+    for(i = 0; i < outCount; i++) \
+        for(j = sameArray ? i + 1 : 0; j < inCount; j++) \
+            PH_kernel_##TYPE(outer[i], inner[j], world, &m); \
+}
+
+PH_PAIR_TYPES(PH_DEFINE_PAIR_TYPE)
 
 /**
  * @brief Creates an empty world.
  */
 World *PH_createWorld() {
-    World *world = (World*)malloc(sizeof(World));
-    //create the bag in which the object will by stored by type
-    world->dynObjBag = Bag_new(&free);
-    world->stObjBag = Bag_new(&free);
-    world->hybObjBag = Bag_new(&free);
+    return PH_createWorldIn(NULL);
+}
+
+/**
+ * @brief Creates an empty world, which allocates everything from an arena, or from the heap if it is NULL.
+ */
+World *PH_createWorldIn(Arena *arena) {
+    int i;
+    World *world = (World*)Arena_allocTagged(sizeof(World), MT_TAG_PHYSICS, arena);
+    world->arena = arena;
+    ObjectArray_initTagged(MT_TAG_PHYSICS, arena, &world->freeObjs);
+    HandleTable_initTagged(MT_TAG_PHYSICS, arena, &world->handles);
+    //create the arrays in which the object will by stored by type
+    ObjectArray_initTagged(MT_TAG_PHYSICS, arena, &world->dynObjs);
+    ObjectArray_initTagged(MT_TAG_PHYSICS, arena, &world->stObjs);
+    ObjectArray_initTagged(MT_TAG_PHYSICS, arena, &world->hybObjs);
 
     //default gravity is 0
     world->gravity.x = world->gravity.y = 0;
     world->stepTime = PH_DEF_STEPTIME;
     //there is no accumulated time yet
     world->deltaLeftover = 0;
+    world->stepFunc = NULL;
+    world->stepState = NULL;
+
+    //no pair handlers yet
+    memset(world->pairTable, 0, sizeof(world->pairTable));
+    memset(world->pairSwap, 0, sizeof(world->pairSwap));
+    world->pairBatches = Bag_newTagged((freeData)&PH_freeBatch, MT_TAG_PHYSICS, arena);
+
+    //not chunked by default, every object is stepped
+    world->chunks = NULL;
+    world->chunkSize = 0;
+    world->chunkCols = world->chunkRows = 0;
+    world->activeRadius = 0;
+    world->dormantInterval = 0;
+    world->stepCount = 0;
+    world->stamp = 0;
+    ObjectArray_initTagged(MT_TAG_PHYSICS, arena, &world->activators);
+    PH_ChunkRefArray_initTagged(MT_TAG_PHYSICS, arena, &world->stepChunks);
+    PH_ChunkRefArray_initTagged(MT_TAG_PHYSICS, arena, &world->forceChunks);
+    ObjectArray_initTagged(MT_TAG_PHYSICS, arena, &world->stepDyn);
+    ObjectArray_initTagged(MT_TAG_PHYSICS, arena, &world->nearHyb);
+    ObjectArray_initTagged(MT_TAG_PHYSICS, arena, &world->nearSt);
+
+    //no tiles yet, they are drawn in the default object colour until told otherwise
+    world->tiles = NULL;
+    world->tileCount = world->tileMaxSize = 0;
+    world->tileDirty = 0;
+    world->tileCols = world->tileRows = 0;
+    world->tileCellStart = world->tileCellItems = NULL;
+    for(i = 0; i < USER_DATA_TYPE_TOTAL; i++)
+        world->tileColors[i].r = world->tileColors[i].g = world->tileColors[i].b = world->tileColors[i].a = 100;
+
     return world;
 }
 
+/**
+ * @brief Returns the arena the world allocates from, NULL if it uses the heap.
+ */
+Arena *PH_getArena(World *world) {
+    return world->arena;
+}
+
 /**
  * @brief Creates an objects at x,y co-ord with given heigh, width, type and mass in the given world.
  */
 Object *PH_createBox(int x, int y, int width, int height, float mass, PH_OBJ_TYPE type, World *world) {
-    //allocate and initilaize
-    Object *box = (Object*)malloc(sizeof(Object));
+    //allocate and initilaize, an arena world reuses its destroyed objects
+    Object *box;
+    if(world->freeObjs.count != 0)
+        box = ObjectArray_pop(&world->freeObjs);
+    else
+        box = (Object*)Arena_allocTagged(sizeof(Object), MT_TAG_PHYSICS, world->arena);
 
     box->world = world;
+    box->handle = HandleTable_add(box, &world->handles);
 
     //default initialization
     box->velocity.x = box->velocity.y = 0;
@@ -111,30 +330,43 @@ Object *PH_createBox(int x, int y, int width, int height, float mass, PH_OBJ_TYP
     box->callBack = NULL;
     box->cbState = NULL;
 
+    //not touching anything yet
+    memset(&box->contacts, 0, sizeof(PH_Contacts));
+
+    //not in any chunk yet, PH_chunkInsert() takes care of it
+    box->chunk = -1;
+    box->stamp = 0;
+    box->activatorHandle = -1;
+
     //default render colour
     box->color.r = box->color.g = box->color.b = box->color.a = 100;
 
     box->type = type;
 
-    //find the correct Bag by type into which the object should be put
+    //find the correct array by type into which the object should be put
     switch (type) {
         //oHandle is the index at which the object is stored
         case STATIC:
             //static objects have infinity mass
             box->invMass = 0;
-            box->oHandle = Bag_push(box, world->stObjBag);
+            box->mass = 0;
+            box->oHandle = ObjectArray_push(box, &world->stObjs);
             break;
         case DYNAMIC:
             box->invMass = 1.0/mass;
-            box->oHandle = Bag_push(box, world->dynObjBag);
-            box->forceSum = world->gravity;
+            box->mass = mass;
+            box->oHandle = ObjectArray_push(box, &world->dynObjs);
+            box->forceSum = VEC2D_scale(&(world->gravity), box->mass);
             break;
         case HYBRID:
             box->invMass = 1.0/mass;
-            box->oHandle = Bag_push(box, world->hybObjBag);
+            box->mass = mass;
+            box->oHandle = ObjectArray_push(box, &world->hybObjs);
             break;
     }
 
+    PH_chunkInsert(box);
+
     //return the newly allocated box
     return box;
 }
@@ -147,20 +379,44 @@ void PH_stepWorld(double delta, World *world) {
     if( (world->deltaLeftover += delta) > PH_SPIRAL_OF_DEATH_CAP)
         world->deltaLeftover = PH_SPIRAL_OF_DEATH_CAP;
 
+    //the tiles added since the last step have to be indexed
+    if(world->tileDirty)
+        PH_buildTiles(world);
+
     //while we still time more than a stepTime chunk long to process, step the world
     while(world->deltaLeftover >= world->stepTime) {
-        //integrating objects positions
-        PH_integrate(world->stepTime, world);
+        //the time this step ends at, measured from the start of delta, if time was capped the oldest is lost
+        if(world->stepFunc != NULL)
+            world->stepFunc(world, delta - world->deltaLeftover + world->stepTime, world->stepState);
+
+        if(world->chunks != NULL) {
+            //the same as below, but only for the chunks which have to be stepped
+            PH_updateActivity(world);
+            PH_integrateChunks(world);
+            PH_testAndResolveChunks(world);
+        } else {
+            //contacts always describe the latest step
+            PH_clearContacts(world);
+
+            //integrating objects positions
+            PH_integrate(world->stepTime, world);
+
+            //resolve collisions, call callback functions
+            PH_testAndResolve(world);
+        }
 
-        //resolve collisions, call callback functions
-        PH_testAndResolve(world);
+        //call the pair handlers with the contacts found during the step
+        PH_dispatchContacts(world);
 
         //update leftover delta time, e.g. we consumed this much time
         world->deltaLeftover -= world->stepTime;
     }
 
-    //reset forces, hybrid to zero, dynamic to gravity
-    PH_resetForces(world);
+    //reset forces, hybrid to zero, dynamic to gravity, in a chunked world only where objects have been stepped
+    if(world->chunks != NULL)
+        PH_resetChunkForces(world);
+    else
+        PH_resetForces(world);
 }
 
 /**
@@ -170,6 +426,16 @@ void PH_setStepTime(double delta, World *world) {
     world->stepTime = delta;
 }
 
+/**
+ * @brief Sets the function called before each step of the world.
+ * @param func Called with the time the step ends at, NULL removes it.
+ * @param state Passed to func.
+ */
+void PH_setStepFunc(PH_stepFunc func, void *state, World *world) {
+    world->stepFunc = func;
+    world->stepState = state;
+}
+
 /**
  * @brief Sets the gravity of a world, will only have apply after the next PH_stepWorld().
  */
@@ -195,6 +461,19 @@ void PH_force(Vector2D *force, Object *obj) {
     obj->forceSum.y += force->y;
 }
 
+/**
+ * @brief Clears the forces applied to an object, dynamic objects keep their gravity, like after a PH_stepWorld().
+ * Lets a step function apply the forces of an object again, instead of adding them twice.
+ */
+void PH_resetForce(Object *obj, World *world) {
+    if(obj->type == DYNAMIC) {
+        obj->forceSum = VEC2D_scale(&(world->gravity), obj->mass);
+    } else {
+        obj->forceSum.x = 0;
+        obj->forceSum.y = 0;
+    }
+}
+
 
 /**
  * @brief Deletes an object from the world, doing this during a callback will result in undefined behaviour.
@@ -203,47 +482,103 @@ void PH_destroyObject(Object *o) {
     if(o == NULL)
         return;
 
-    Bag *oBag = NULL;
+    ObjectArray *objs = NULL;
     World *world = o->world;
 
-    //select the correct bag by Object type
+    //select the correct array by Object type
     switch (o->type) {
         case STATIC:
-            oBag = world->stObjBag;
+            objs = &world->stObjs;
             break;
         case DYNAMIC:
-            oBag = world->dynObjBag;
+            objs = &world->dynObjs;
             break;
         case HYBRID:
-            oBag = world->hybObjBag;
+            objs = &world->hybObjs;
             break;
     }
 
     //here the handles come in handy, we can remove objects with O(1) access time
-    if(oBag != NULL) {
+    if(objs != NULL) {
+        //anything still referring to the object by handle will see it is gone
+        HandleTable_remove(o->handle, &world->handles);
+        //the world should not keep anything pointing to the object
+        PH_setActivator(0, o);
+        PH_chunkRemove(o);
+
         //remove object
-        Bag_unorderedRemove(o->oHandle, oBag);
+        ObjectArray_unorderedRemove(o->oHandle, objs);
         //because we used unordered remove, we have to update the swapped object's oHandle
-        //check if it wasn't the last element in the Bag
-        if(o->oHandle != oBag->elemCount)
-            ((Object*) oBag->vector[o->oHandle])->oHandle = o->oHandle;
-        //Object is not a multi-malloc type, we can simply free it
-        free(o);
+        //check if it wasn't the last element in the array
+        if(o->oHandle != objs->count)
+            objs->data[o->oHandle]->oHandle = o->oHandle;
+        //Object is not a multi-malloc type, we can simply free it, or keep it for the next one in an arena
+        if(world->arena != NULL)
+            ObjectArray_push(o, &world->freeObjs);
+        else
+            MT_free(o);
     }
 }
 
+/**
+ * @brief Returns the generational handle of an object, it goes stale when the object is destroyed.
+ */
+Handle PH_getHandle(Object *obj) {
+    return obj->handle;
+}
+
+/**
+ * @brief Returns the object of a handle.
+ * @return the object, NULL if it has been destroyed or the handle is HANDLE_NULL.
+ */
+Object *PH_getObject(Handle handle, World *world) {
+    return (Object*)HandleTable_get(handle, &world->handles);
+}
+
 /**
  * @brief Free up all the memory the objects and the world take up.
  */
 void PH_destroyWorld(World *world) {
-    if(world == NULL)
+    int i;
+    Object **o;
+
+    //everything is released with the arena
+    if(world == NULL || world->arena != NULL)
         return;
 
-    //here one means that for each object in the bag, the free function passed at Bag creation will be called
-    Bag_free(world->dynObjBag, 1);
-    Bag_free(world->hybObjBag, 1);
-    Bag_free(world->stObjBag, 1);
-    free(world);
+    //the arrays only hold pointers, the objects are freed one by one
+    ARRAY_FOREACH(o, &world->dynObjs)
+        MT_free(*o);
+    ARRAY_FOREACH(o, &world->hybObjs)
+        MT_free(*o);
+    ARRAY_FOREACH(o, &world->stObjs)
+        MT_free(*o);
+    ObjectArray_free(&world->dynObjs);
+    ObjectArray_free(&world->hybObjs);
+    ObjectArray_free(&world->stObjs);
+    //here one means that for each batch in the bag, the free function passed at Bag creation will be called
+    Bag_free(world->pairBatches, 1);
+
+    //free the chunks' indices, the objects are already freed
+    if(world->chunks != NULL) {
+        for(i = 0; i < world->chunkCols * world->chunkRows; i++) {
+            ObjectArray_free(&world->chunks[i].home);
+            ObjectArray_free(&world->chunks[i].overlap);
+        }
+        MT_free(world->chunks);
+    }
+    PH_ChunkRefArray_free(&world->stepChunks);
+    PH_ChunkRefArray_free(&world->forceChunks);
+    ObjectArray_free(&world->stepDyn);
+    ObjectArray_free(&world->nearHyb);
+    ObjectArray_free(&world->nearSt);
+    ObjectArray_free(&world->activators);
+    ObjectArray_free(&world->freeObjs);
+    HandleTable_free(&world->handles);
+    MT_free(world->tiles);
+    MT_free(world->tileCellStart);
+    MT_free(world->tileCellItems);
+    MT_free(world);
 }
 
 
@@ -263,6 +598,8 @@ void PH_setPosition(Vector2D vec, Object *obj) {
 
     obj->aabb.center.x = vec.x + obj->aabb.hWidth;
     obj->aabb.center.y = vec.y + obj->aabb.hHeight;
+
+    PH_chunkUpdate(obj);
 }
 
 /**
@@ -281,6 +618,135 @@ void PH_setCallback(PH_callback callBack, void *state, Object *obj) {
     obj->callBack = callBack;
 }
 
+/**
+ * @brief Registers a handler for the collisions of two kinds of objects.
+ * @param a The UserDataType of the objects passed as A.
+ * @param b The UserDataType of the objects passed as B.
+ * @param handler The function called once per world step with the contacts of the pair, NULL to ignore them.
+ * @param state State pointer passed to the handler.
+ *
+ * Objects of the two types will never collide with each other, the pair only generates contacts. Registering the same
+ * pair again replaces its handler, but keeps its position in the dispatch order.
+ */
+void PH_setPairHandler(UserDataType a, UserDataType b, PH_pairHandler handler, void *state, World *world) {
+    PH_ContactBatch *batch = world->pairTable[a][b];
+
+    //first registration of the pair, the batch is shared by both orders
+    if(batch == NULL) {
+        batch = (PH_ContactBatch*)Arena_callocTagged(1, sizeof(PH_ContactBatch), MT_TAG_PHYSICS, world->arena);
+        batch->arena = world->arena;
+        Bag_push(batch, world->pairBatches);
+        world->pairTable[a][b] = world->pairTable[b][a] = batch;
+    }
+
+    //contacts found the other way around will be swapped, a pair of the same types is never swapped
+    world->pairSwap[b][a] = a != b;
+    world->pairSwap[a][b] = 0;
+    batch->handler = handler;
+    batch->state = state;
+}
+
+/**
+ * @brief Divides the world into a grid of chunks, only the chunks around activators will be stepped every time.
+ * @param chunkSize The width and height of a chunk, the grid starts at the origin.
+ * @param cols The number of chunks along the x axis, objects further away are put into the last column.
+ * @param rows The number of chunks along the y axis, objects further away are put into the last row.
+ * @param activeRadius The chunks this many chunks away from the chunks of an activator are stepped every time.
+ * @param dormantInterval The other chunks are stepped every this many steps, by a longer delta, 0 freezes them.
+ *
+ * Objects in the same chunk are always stepped together. An object is only tested for collisions with objects around
+ * it, when its own chunk is stepped, so activeRadius should be big enough for the chunks around the activators to
+ * include anything the activators can interact with. Forces applied to objects in chunks which are not stepped are kept
+ * until their chunk is stepped. Can only be called once per world.
+ */
+void PH_setChunks(float chunkSize, int cols, int rows, int activeRadius, int dormantInterval, World *world) {
+    int i;
+
+    if(world->chunks != NULL)
+        return;
+
+    world->chunkSize = chunkSize;
+    world->chunkCols = cols;
+    world->chunkRows = rows;
+    world->activeRadius = activeRadius;
+    world->dormantInterval = dormantInterval;
+
+    world->chunks = (PH_Chunk*)Arena_callocTagged((size_t)(cols * rows), sizeof(PH_Chunk), MT_TAG_PHYSICS,
+                                                  world->arena);
+    for(i = 0; i < cols * rows; i++) {
+        ObjectArray_initTagged(MT_TAG_PHYSICS, world->arena, &world->chunks[i].home);
+        ObjectArray_initTagged(MT_TAG_PHYSICS, world->arena, &world->chunks[i].overlap);
+    }
+
+    //store the objects created so far
+    for(i = 0; i < world->stObjs.count; i++)
+        PH_chunkInsert(world->stObjs.data[i]);
+    for(i = 0; i < world->dynObjs.count; i++)
+        PH_chunkInsert(world->dynObjs.data[i]);
+    for(i = 0; i < world->hybObjs.count; i++)
+        PH_chunkInsert(world->hybObjs.data[i]);
+}
+
+/**
+ * @brief Sets whether an object keeps the chunks around it active, see PH_setChunks().
+ */
+void PH_setActivator(int activator, Object *obj) {
+    ObjectArray *activators = &obj->world->activators;
+
+    if(activator && obj->activatorHandle < 0) {
+        obj->activatorHandle = ObjectArray_push(obj, activators);
+    } else if(!activator && obj->activatorHandle >= 0) {
+        //the last activator is moved into the hole, its handle has to follow
+        ObjectArray_unorderedRemove(obj->activatorHandle, activators);
+        if(obj->activatorHandle != activators->count)
+            activators->data[obj->activatorHandle]->activatorHandle = obj->activatorHandle;
+        obj->activatorHandle = -1;
+    }
+}
+
+/**
+ * @brief Adds a piece of static geometry at x,y with given width and height.
+ * @param type The UserDataType of the tile, used to look up pair handlers and the colour of the tile.
+ * @return The index of the tile, -1 if it does not fit in the 16 bit coordinates.
+ *
+ * Tiles can not be moved or removed, and cost only a fraction of an Object. They are indexed before the next
+ * PH_stepWorld().
+ */
+int PH_addTile(int x, int y, int width, int height, UserDataType type, World *world) {
+    PH_Tile *t;
+
+    if(x < INT16_MIN || y < INT16_MIN || x + width > INT16_MAX || y + height > INT16_MAX)
+        return -1;
+
+    //grow the array if needed
+    if(world->tileCount == world->tileMaxSize) {
+        int size = world->tileMaxSize ? world->tileMaxSize * 2 : 64;
+        world->tiles = (PH_Tile*)Arena_reallocTagged(world->tiles, sizeof(PH_Tile) * world->tileMaxSize,
+                                                     sizeof(PH_Tile) * size, MT_TAG_PHYSICS, world->arena);
+        world->tileMaxSize = size;
+    }
+
+    t = &world->tiles[world->tileCount];
+    t->min[0] = (int16_t)x;
+    t->min[1] = (int16_t)y;
+    t->max[0] = (int16_t)(x + width);
+    t->max[1] = (int16_t)(y + height);
+    t->type = (uint8_t)type;
+    world->tileDirty = 1;
+
+    return world->tileCount++;
+}
+
+/**
+ * @brief Sets the colour tiles of a type are rendered with.
+ */
+void PH_setTileColor(UserDataType type, Uint8 r, Uint8 g, Uint8 b, Uint8 a, World *world) {
+    world->tileColors[type].r = r;
+    world->tileColors[type].g = g;
+    world->tileColors[type].b = b;
+    world->tileColors[type].a = a;
+}
+
 /**
  * @brief Set the color of the object, can be used for convenient rendering.
  */
@@ -295,29 +761,46 @@ void PH_setColor(Uint8 r, Uint8 g, Uint8 b, Uint8 a, Object *o) {
  * @brief Render the objects by their colours.
  */
 void PH_renderObjects(World *world) {
-    //these are for iterating over elements
-    int i; //array index iterator
-    int elemCount = 0; //will store the number of elements in a Bag
-    Object **objVector = NULL; //will store a type cast array
-
-
-    objVector = (Object**)world->stObjBag->vector; //cache the Bag's backing array
-    elemCount = world->stObjBag->elemCount; //cache the Bag's element count
-    for(i=0;i<elemCount;i++)
-        AABB_renderColor(&(objVector[i]->aabb), objVector[i]->color);
-
-
-    objVector = (Object**)world->dynObjBag->vector; //cache the Bag's backing array
-    elemCount = world->dynObjBag->elemCount; //cache the Bag's element count
-    for(i=0;i<elemCount;i++)
-        AABB_renderColor(&(objVector[i]->aabb), objVector[i]->color);
-
+    //the rectangles are collected in frame memory and drawn in batches of the same colour
+    int count = world->stObjs.count + world->dynObjs.count + world->hybObjs.count;
+    SDL_Rect *rects = (SDL_Rect*)Frame_alloc(sizeof(SDL_Rect) * count);
+    SDL_Color *colors = (SDL_Color*)Frame_alloc(sizeof(SDL_Color) * count);
+    Object **o;
+    int i = 0;
+
+    //the tiles are always in the background
+    PH_renderTiles(world);
+
+    ARRAY_FOREACH(o, &world->stObjs) {
+        rects[i] = AABB_toRect(&(*o)->aabb);
+        colors[i++] = (*o)->color;
+    }
+    ARRAY_FOREACH(o, &world->dynObjs) {
+        rects[i] = AABB_toRect(&(*o)->aabb);
+        colors[i++] = (*o)->color;
+    }
+    ARRAY_FOREACH(o, &world->hybObjs) {
+        rects[i] = AABB_toRect(&(*o)->aabb);
+        colors[i++] = (*o)->color;
+    }
+    AABB_renderRects(rects, colors, count);
+}
 
-    objVector = (Object**)world->hybObjBag->vector; //cache the Bag's backing array
-    elemCount = world->hybObjBag->elemCount; //cache the Bag's element count
-    for(i=0;i<elemCount;i++)
-        AABB_renderColor(&(objVector[i]->aabb), objVector[i]->color);
+/**
+ * @brief Render the tiles by the colour of their type.
+ */
+void PH_renderTiles(World *world) {
+    SDL_Rect *rects = (SDL_Rect*)Frame_alloc(sizeof(SDL_Rect) * world->tileCount);
+    SDL_Color *colors = (SDL_Color*)Frame_alloc(sizeof(SDL_Color) * world->tileCount);
+    int i;
+    AABB a;
 
+    for(i = 0; i < world->tileCount; i++) {
+        PH_tileAABB(&world->tiles[i], &a);
+        rects[i] = AABB_toRect(&a);
+        colors[i] = world->tileColors[world->tiles[i].type];
+    }
+    AABB_renderRects(rects, colors, world->tileCount);
 }
 
 
@@ -329,15 +812,15 @@ void PH_renderObjects(World *world) {
 void PH_queryPoint(Vector2D point, PH_OBJ_TYPE types, int cap, Bag *bag, World *world) {
     //i is the array index iterator, found holds the number of elements found
     int i, found = 0;
-    int elemCount = 0; //Bag elemcount
-    Object **vector = NULL; //Bag's backing array
+    int elemCount = 0; //array elemcount
+    Object **vector = NULL; //array's storage
 
     Bag_fastClear(bag);
 
 
     if(types & DYNAMIC) {
-        elemCount = world->dynObjBag->elemCount; //cache Bag's element count
-        vector = (Object**)world->dynObjBag->vector; //cache Bag's backing array
+        elemCount = world->dynObjs.count; //cache the array's element count
+        vector = world->dynObjs.data; //cache the array's storage
         //while the array lasts and if a cap has been specified
         for(i = 0; i < elemCount && (found < cap || cap <= 0); i++) {
             if(AABB_vs_Point(&(vector[i]->aabb), point.x, point.y)) {
@@ -347,8 +830,8 @@ void PH_queryPoint(Vector2D point, PH_OBJ_TYPE types, int cap, Bag *bag, World *
     }
 
     if(types & HYBRID) {
-        elemCount = world->hybObjBag->elemCount;
-        vector = (Object**)world->hybObjBag->vector;
+        elemCount = world->hybObjs.count;
+        vector = world->hybObjs.data;
         for(i = 0; i < elemCount && (found < cap || cap <=0); i++) {
             if(AABB_vs_Point(&(vector[i]->aabb), point.x, point.y)) {
                 Bag_push(vector[i], bag);
@@ -357,8 +840,8 @@ void PH_queryPoint(Vector2D point, PH_OBJ_TYPE types, int cap, Bag *bag, World *
     }
 
     if(types & STATIC) {
-        elemCount = world->stObjBag->elemCount;
-        vector = (Object**)world->stObjBag->vector;
+        elemCount = world->stObjs.count;
+        vector = world->stObjs.data;
         for(i = 0; i < elemCount && (found < cap || cap<=0); i++) {
             if(AABB_vs_Point(&(vector[i]->aabb), point.x, point.y)) {
                 Bag_push(vector[i], bag);
@@ -380,8 +863,8 @@ void PH_integrate(double delta, World *world) {
     Object **objs = NULL;
 
     //add force to velocity, dynamic objects
-    elemCount = world->dynObjBag->elemCount;
-    objs = (Object**)world->dynObjBag->vector;
+    elemCount = world->dynObjs.count;
+    objs = world->dynObjs.data;
     for(i = 0; i<elemCount; i++) {
         //update velocity
         objs[i]->velocity.x += objs[i]->forceSum.x * objs[i]->invMass * delta;
@@ -403,8 +886,8 @@ void PH_integrate(double delta, World *world) {
 
 
     //add force to velocity, hybrid
-    elemCount = world->hybObjBag->elemCount;
-    objs = (Object**)world->hybObjBag->vector;
+    elemCount = world->hybObjs.count;
+    objs = world->hybObjs.data;
     for(i = 0; i<elemCount; i++) {
         //update velocity
         objs[i]->velocity.x += objs[i]->forceSum.x * objs[i]->invMass * delta;
@@ -441,76 +924,27 @@ void PH_capVelocity(Object *obj) {
 
 
 void PH_testAndResolve(World *world) {
-    //iterators
-    int i, j;
-    int elemCountOut = 0, elemCountIn = 0;
-    Object **vectorOut = NULL, **vectorIn = NULL;
-
-    //used in the inner loop
-    PH_Manifold m;
-    Object *A = NULL, *B = NULL;
-
-
-    //the inner data loop is always dynamic objects
-    elemCountIn = world->dynObjBag->elemCount;
-    vectorIn = (Object**)world->dynObjBag->vector;
-
-    //dynamic vs dynamic
-    elemCountOut = world->dynObjBag->elemCount;
-    vectorOut = (Object**)world->dynObjBag->vector;
-    for(i = 0; i<elemCountOut - 1; i++) {
-        for(j = i+1; j<elemCountIn; j++) {
-            PH_testTwoObjects(vectorOut[i], vectorIn[j], DYNAMIC_DYNAMIC, &m);
-        }
-    }
-
-    //hybrid vs dynamic
-    elemCountOut = world->hybObjBag->elemCount;
-    vectorOut = (Object**)world->hybObjBag->vector;
-    for(i = 0; i<elemCountOut; i++) {
-        for(j = 0; j<elemCountIn; j++) {
-            PH_testTwoObjects(vectorOut[i], vectorIn[j], HYBRID_DYNAMIC, &m);
-        }
-    }
-
-    //static vs dynamic
-    elemCountOut = world->stObjBag->elemCount;
-    vectorOut = (Object**)world->stObjBag->vector;
-    for(i = 0; i<elemCountOut; i++) {
-        for(j = 0; j<elemCountIn; j++) {
-            PH_testTwoObjects(vectorOut[i], vectorIn[j], STATIC_DYNAMIC, &m);
-        }
-    }
-
-    //except in this case, inner is not dynamic
-    //hybrid vs hybrid
-    elemCountIn = elemCountOut = world->hybObjBag->elemCount;
-    vectorIn = vectorOut = (Object**)world->hybObjBag->vector;
-    for(i = 0; i<elemCountOut - 1; i++) {
-        for(j = i + 1; j<elemCountIn; j++) {
-            PH_testTwoObjects(vectorOut[i], vectorIn[j], HYBRID_HYBRID, &m);
-        }
-    }
+    //cache the arrays' storage and element counts
+    Object **dyn = world->dynObjs.data;
+    int dynCount = world->dynObjs.count;
+    Object **hyb = world->hybObjs.data;
+    int hybCount = world->hybObjs.count;
+    Object **st = world->stObjs.data;
+    int stCount = world->stObjs.count;
+
+    //the inner data loop is always dynamic objects, except for hybrid vs hybrid
+    PH_testPairs_DYNAMIC_DYNAMIC(dyn, dynCount, dyn, dynCount, 1, world);
+    PH_testPairs_HYBRID_DYNAMIC(hyb, hybCount, dyn, dynCount, 0, world);
+    PH_testPairs_STATIC_DYNAMIC(st, stCount, dyn, dynCount, 0, world);
+    PH_testTiles(dyn, dynCount, world);
+    PH_testPairs_HYBRID_HYBRID(hyb, hybCount, hyb, hybCount, 1, world);
+    PH_testTiles(hyb, hybCount, world);
 }
 
-void PH_testTwoObjects(Object *A, Object *B, PH_COLL_TYPE type, PH_Manifold *m) {
-    //test if the two object are overlapping
-    if (PH_testOverlap(A, B)) {
-        //generate manifold first, because the callback functions might need it
-        PH_generateManifold(A, B, type, m);
-        //after generating manifold, we ask the callback functions (if thy exits)
-        //do their whatever and have them return if the two object should collide
-        if (PH_testCallback(A, B, m))
-            PH_resolveCollision(m);
-
-    }
-}
-
-int PH_testOverlap(Object *A, Object *B) {
-    if (AABB_vs_AABB(&(A->aabb), &(B->aabb)) != 0)
-        return 1;
-
-    return 0;
+static inline int PH_testOverlap(Object *A, Object *B) {
+    //same as AABB_vs_AABB(), but this one can be inlined into the kernels
+    return fabsf(A->aabb.center.x - B->aabb.center.x) < A->aabb.hWidth + B->aabb.hWidth &&
+           fabsf(A->aabb.center.y - B->aabb.center.y) < A->aabb.hHeight + B->aabb.hHeight;
 }
 
 
@@ -521,11 +955,12 @@ void PH_generateManifold(Object *objA, Object *objB, PH_COLL_TYPE type, PH_Manif
     dest->A = objA;
     dest->B = objB;
     dest->type = type;
+    dest->tile = NULL;
 
-    //chache the objects' defining AABBs
-    AABB *A = &(objA->aabb);
-    AABB *B = &(objB->aabb);
+    PH_aabbManifold(&(objA->aabb), &(objB->aabb), dest);
+}
 
+void PH_aabbManifold(AABB *A, AABB *B, PH_Manifold *dest) {
     //get the normal vector
     dest->n = VEC2D_sub(&(B->center), &(A->center));
 
@@ -566,25 +1001,538 @@ int PH_testCallback(Object *A, Object *B, PH_Manifold *m) {
 }
 
 
-void PH_resolveCollision(PH_Manifold *m) {
+static inline void PH_resolveCollision(PH_Manifold *m) {
+    //B is always a dynamic object, the kernels only call this for pairs that resolve
+    Object *B = m->B;
+
+    if(m->n.x != 0){
+        B->aabb.center.x += m->n.x * m->depth;
+        B->velocity.x = 0;
+    } else {
+        B->aabb.center.y += m->n.y * m->depth;
+        B->velocity.y = 0;
+    }
+}
+
+int PH_testProximity(Object *objA, Object *objB, PH_COLL_TYPE type, PH_Manifold *dest) {
+    if(!PH_aabbProximity(&(objA->aabb), &(objB->aabb), dest))
+        return 0;
+
+    dest->A = objA;
+    dest->B = objB;
+    dest->type = type;
+    dest->tile = NULL;
+    return 1;
+}
+
+int PH_aabbProximity(AABB *A, AABB *B, PH_Manifold *dest) {
+    Vector2D d = VEC2D_sub(&(B->center), &(A->center));
+
+    //distance between the facing sides, negative means they overlap on that axis
+    float gapX = fabsf(d.x) - (A->hWidth + B->hWidth);
+    float gapY = fabsf(d.y) - (A->hHeight + B->hHeight);
+
+    //they have to be next to each other on one axis and overlap on the other one
+    if(gapX >= 0 && gapX <= PH_CONTACT_SKIN && gapY < 0) {
+        dest->n.x = d.x < 0 ? -1 : 1;
+        dest->n.y = 0;
+        dest->depth = -gapX;
+    } else if(gapY >= 0 && gapY <= PH_CONTACT_SKIN && gapX < 0) {
+        dest->n.x = 0;
+        dest->n.y = d.y < 0 ? -1 : 1;
+        dest->depth = -gapY;
+    } else {
+        return 0;
+    }
+
+    return 1;
+}
+
+void PH_recordContact(PH_Manifold *m) {
     Object *A = m->A;
-    //B is always a dynamic object, except when it's hybrid in hybrid vs hybrid
     Object *B = m->B;
+    PH_SIDE sideB;
+
+    //the normal points from A to B, so B is touched on the side facing against it
+    if(m->n.x != 0)
+        sideB = m->n.x > 0 ? PH_LEFT : PH_RIGHT;
+    else
+        sideB = m->n.y > 0 ? PH_BOTTOM : PH_TOP;
+
+    B->contacts.flags |= PH_CONTACT(sideB);
+    B->contacts.with[sideB] = A;
+
+    //static objects and tiles don't maintain contacts, for the others the opposite side
+    //is always the neighbouring enum value (left-right, top-bottom)
+    if(A != NULL && A->type != STATIC) {
+        PH_SIDE sideA = (PH_SIDE)(sideB ^ 1);
+        A->contacts.flags |= PH_CONTACT(sideA);
+        A->contacts.with[sideA] = B;
+    }
+}
+
+void PH_clearContacts(World *world) {
+    //helper local variables
+    int i;
+    int elemCount = world->dynObjs.count;
+    Object **objvector = world->dynObjs.data;
+
+    for(i=0;i<elemCount;i++)
+        memset(&objvector[i]->contacts, 0, sizeof(PH_Contacts));
+
+    elemCount = world->hybObjs.count;
+    objvector = world->hybObjs.data;
+    for(i=0;i<elemCount;i++)
+        memset(&objvector[i]->contacts, 0, sizeof(PH_Contacts));
+}
+
+void PH_chunkRange(AABB *a, float margin, World *world, int range[4]) {
+    float size = world->chunkSize;
+
+    range[0] = (int)floorf((a->center.x - a->hWidth - margin) / size);
+    range[1] = (int)floorf((a->center.y - a->hHeight - margin) / size);
+    range[2] = (int)floorf((a->center.x + a->hWidth + margin) / size);
+    range[3] = (int)floorf((a->center.y + a->hHeight + margin) / size);
+
+    //anything outside of the grid belongs to the border chunks
+    range[0] = range[0] < 0 ? 0 : (range[0] >= world->chunkCols ? world->chunkCols - 1 : range[0]);
+    range[2] = range[2] < 0 ? 0 : (range[2] >= world->chunkCols ? world->chunkCols - 1 : range[2]);
+    range[1] = range[1] < 0 ? 0 : (range[1] >= world->chunkRows ? world->chunkRows - 1 : range[1]);
+    range[3] = range[3] < 0 ? 0 : (range[3] >= world->chunkRows ? world->chunkRows - 1 : range[3]);
+}
+
+int PH_chunkIndex(Vector2D *point, World *world) {
+    int x = (int)floorf(point->x / world->chunkSize);
+    int y = (int)floorf(point->y / world->chunkSize);
 
-    switch (m->type) {
-        case STATIC_DYNAMIC:
-        case HYBRID_DYNAMIC:
-            if(m->n.x != 0){
-                B->aabb.center.x += m->n.x * m->depth;
-                B->velocity.x = 0;
-            } else {
-                B->aabb.center.y += m->n.y * m->depth;
-                B->velocity.y = 0;
+    x = x < 0 ? 0 : (x >= world->chunkCols ? world->chunkCols - 1 : x);
+    y = y < 0 ? 0 : (y >= world->chunkRows ? world->chunkRows - 1 : y);
+    return y * world->chunkCols + x;
+}
+
+void PH_chunkInsert(Object *o) {
+    World *world = o->world;
+    int i, h, x, y;
+
+    if(world->chunks == NULL)
+        return;
+
+    //moving objects are stepped with the chunk their center is in
+    if(o->type != STATIC) {
+        o->chunk = PH_chunkIndex(&o->aabb.center, world);
+        o->chunkHandle = ObjectArray_push(o, &world->chunks[o->chunk].home);
+    }
+
+    //objects that others can collide with are stored in every chunk they overlap
+    if(o->type != DYNAMIC) {
+        PH_chunkRange(&o->aabb, 0, world, o->chunkRange);
+        for(y = o->chunkRange[1]; y <= o->chunkRange[3]; y++)
+            for(x = o->chunkRange[0]; x <= o->chunkRange[2]; x++) {
+                i = PH_overlapIndex(o, x, y);
+                h = ObjectArray_push(o, &world->chunks[y * world->chunkCols + x].overlap);
+                if(i < PH_OVERLAP_HANDLES)
+                    o->overlapHandles[i] = h;
             }
-            break;
     }
 }
 
+void PH_chunkRemove(Object *o) {
+    World *world = o->world;
+    ObjectArray *objs;
+    int i, h, x, y;
+
+    if(world->chunks == NULL)
+        return;
+
+    if(o->chunk >= 0) {
+        //same as with oHandles, the swapped object's handle has to be updated
+        objs = &world->chunks[o->chunk].home;
+        ObjectArray_unorderedRemove(o->chunkHandle, objs);
+        if(o->chunkHandle != objs->count)
+            objs->data[o->chunkHandle]->chunkHandle = o->chunkHandle;
+        o->chunk = -1;
+    }
+
+    if(o->type != DYNAMIC)
+        for(y = o->chunkRange[1]; y <= o->chunkRange[3]; y++)
+            for(x = o->chunkRange[0]; x <= o->chunkRange[2]; x++) {
+                objs = &world->chunks[y * world->chunkCols + x].overlap;
+                //only objects spanning more chunks than they have handles for have to be searched for
+                i = PH_overlapIndex(o, x, y);
+                if(i < PH_OVERLAP_HANDLES) {
+                    h = o->overlapHandles[i];
+                } else {
+                    for(h = 0; h < objs->count && objs->data[h] != o; h++)
+                        ;
+                    if(h == objs->count)
+                        continue;
+                }
+
+                //the last object of the list is moved into the hole, its handle for this chunk has to follow
+                ObjectArray_unorderedRemove(h, objs);
+                if(h != objs->count && (i = PH_overlapIndex(objs->data[h], x, y)) < PH_OVERLAP_HANDLES)
+                    objs->data[h]->overlapHandles[i] = h;
+            }
+}
+
+int PH_overlapIndex(Object *o, int x, int y) {
+    return (y - o->chunkRange[1]) * (o->chunkRange[2] - o->chunkRange[0] + 1) + x - o->chunkRange[0];
+}
+
+void PH_chunkUpdate(Object *o) {
+    World *world = o->world;
+    int range[4];
+
+    if(world->chunks == NULL)
+        return;
+
+    //only touch the chunks if the object has left them, this is the common case
+    if(o->type != STATIC && PH_chunkIndex(&o->aabb.center, world) != o->chunk) {
+        PH_chunkRemove(o);
+        PH_chunkInsert(o);
+    } else if(o->type != DYNAMIC) {
+        PH_chunkRange(&o->aabb, 0, world, range);
+        if(memcmp(range, o->chunkRange, sizeof(range)) != 0) {
+            PH_chunkRemove(o);
+            PH_chunkInsert(o);
+        }
+    }
+}
+
+void PH_updateActivity(World *world) {
+    int i, x, y;
+    int range[4];
+    int r = world->activeRadius;
+    uint32_t step = ++world->stepCount;
+    PH_Chunk *chunk;
+    Object **activators = world->activators.data;
+
+    PH_ChunkRefArray_clear(&world->stepChunks);
+
+    //the chunks around the activators are stepped every time
+    for(i = 0; i < world->activators.count; i++) {
+        PH_chunkRange(&activators[i]->aabb, r * world->chunkSize, world, range);
+        for(y = range[1]; y <= range[3]; y++)
+            for(x = range[0]; x <= range[2]; x++) {
+                chunk = &world->chunks[y * world->chunkCols + x];
+                if(chunk->activeStep != step) {
+                    chunk->activeStep = step;
+                    chunk->stepDelta = world->stepTime;
+                    PH_ChunkRefArray_push(chunk, &world->stepChunks);
+                }
+            }
+    }
+
+    //the dormant ones catch up with the time they have missed once in a while
+    if(world->dormantInterval > 0 && step % world->dormantInterval == 0)
+        for(i = 0; i < world->chunkCols * world->chunkRows; i++) {
+            chunk = &world->chunks[i];
+            if(chunk->activeStep != step) {
+                chunk->activeStep = step;
+                chunk->stepDelta = world->stepTime * world->dormantInterval;
+                PH_ChunkRefArray_push(chunk, &world->stepChunks);
+            }
+        }
+}
+
+void PH_integrateChunks(World *world) {
+    int i, j;
+    int elemCount;
+    double delta;
+    Object *o;
+    Object **objs;
+    PH_Chunk **chunks = world->stepChunks.data;
+
+    //same as PH_clearContacts() and PH_integrate() for the objects of the stepped chunks
+    for(i = 0; i < world->stepChunks.count; i++) {
+        PH_queueForceReset(chunks[i], world);
+        delta = chunks[i]->stepDelta;
+        elemCount = chunks[i]->home.count;
+        objs = chunks[i]->home.data;
+        for(j = 0; j < elemCount; j++) {
+            o = objs[j];
+            memset(&o->contacts, 0, sizeof(PH_Contacts));
+
+            o->velocity.x += o->forceSum.x * o->invMass * delta;
+            o->velocity.y += o->forceSum.y * o->invMass * delta;
+            PH_capVelocity(o);
+
+            o->lastPos = o->aabb.center;
+            o->aabb.center.x += o->velocity.x * delta;
+            o->aabb.center.y += o->velocity.y * delta;
+        }
+    }
+
+    //move the objects to their new chunks, only after all of them have been integrated, otherwise
+    //an object could be stepped twice, backwards, because removal swaps in the last element
+    //an object leaving for a chunk which is not stepped still needs its forces reset
+    for(i = 0; i < world->stepChunks.count; i++)
+        for(j = chunks[i]->home.count - 1; j >= 0; j--) {
+            o = chunks[i]->home.data[j];
+            PH_chunkUpdate(o);
+            PH_queueForceReset(&world->chunks[o->chunk], world);
+        }
+}
+
+void PH_queueForceReset(PH_Chunk *chunk, World *world) {
+    if(!chunk->forceReset) {
+        chunk->forceReset = 1;
+        PH_ChunkRefArray_push(chunk, &world->forceChunks);
+    }
+}
+
+void PH_resetChunkForces(World *world) {
+    int i, j;
+    PH_Chunk **chunks = world->forceChunks.data;
+
+    for(i = 0; i < world->forceChunks.count; i++) {
+        for(j = 0; j < chunks[i]->home.count; j++)
+            PH_resetForce(chunks[i]->home.data[j], world);
+        chunks[i]->forceReset = 0;
+    }
+    PH_ChunkRefArray_clear(&world->forceChunks);
+}
+
+void PH_testAndResolveChunks(World *world) {
+    int i, j, k, x, y;
+    int range[4];
+    uint32_t stamp = ++world->stamp;
+    Object *o;
+    Object **objs;
+    ObjectArray *home, *overlap;
+    PH_Chunk *chunk;
+    PH_Chunk **chunks = world->stepChunks.data;
+
+    ObjectArray_clear(&world->stepDyn);
+    ObjectArray_clear(&world->nearHyb);
+    ObjectArray_clear(&world->nearSt);
+
+    //gather the stepped dynamic objects and everything they and the stepped hybrids can reach,
+    //the stamps make sure every chunk and object is only visited once
+    for(i = 0; i < world->stepChunks.count; i++) {
+        home = &chunks[i]->home;
+        for(j = 0; j < home->count; j++) {
+            o = home->data[j];
+            if(o->type == DYNAMIC)
+                ObjectArray_push(o, &world->stepDyn);
+
+            //objects within the contact skin count as touching, so they have to be found too
+            PH_chunkRange(&o->aabb, PH_CONTACT_SKIN, world, range);
+            for(y = range[1]; y <= range[3]; y++)
+                for(x = range[0]; x <= range[2]; x++) {
+                    chunk = &world->chunks[y * world->chunkCols + x];
+                    if(chunk->stamp == stamp)
+                        continue;
+                    chunk->stamp = stamp;
+
+                    overlap = &chunk->overlap;
+                    objs = overlap->data;
+                    for(k = 0; k < overlap->count; k++)
+                        if(objs[k]->stamp != stamp) {
+                            objs[k]->stamp = stamp;
+                            ObjectArray_push(objs[k], objs[k]->type == HYBRID ? &world->nearHyb : &world->nearSt);
+                        }
+                }
+        }
+    }
+
+    //the kernels see the objects in the same order as without chunks
+    //empty arrays have no storage yet, qsort must not get NULL
+    if(world->stepDyn.count > 1)
+        qsort(world->stepDyn.data, world->stepDyn.count, sizeof(Object*), &PH_compareHandles);
+    if(world->nearHyb.count > 1)
+        qsort(world->nearHyb.data, world->nearHyb.count, sizeof(Object*), &PH_compareHandles);
+    if(world->nearSt.count > 1)
+        qsort(world->nearSt.data, world->nearSt.count, sizeof(Object*), &PH_compareHandles);
+
+    PH_testPairs_DYNAMIC_DYNAMIC(world->stepDyn.data, world->stepDyn.count,
+                                 world->stepDyn.data, world->stepDyn.count, 1, world);
+    PH_testPairs_HYBRID_DYNAMIC(world->nearHyb.data, world->nearHyb.count,
+                                world->stepDyn.data, world->stepDyn.count, 0, world);
+    PH_testPairs_STATIC_DYNAMIC(world->nearSt.data, world->nearSt.count,
+                                world->stepDyn.data, world->stepDyn.count, 0, world);
+    PH_testTiles(world->stepDyn.data, world->stepDyn.count, world);
+    PH_testPairs_HYBRID_HYBRID(world->nearHyb.data, world->nearHyb.count,
+                               world->nearHyb.data, world->nearHyb.count, 1, world);
+    PH_testTiles(world->nearHyb.data, world->nearHyb.count, world);
+}
+
+int PH_compareHandles(const void *a, const void *b) {
+    return (*(Object* const*)a)->oHandle - (*(Object* const*)b)->oHandle;
+}
+
+void PH_buildTiles(World *world) {
+    int i, x, y, c;
+    int minX = INT16_MAX, minY = INT16_MAX, maxX = INT16_MIN, maxY = INT16_MIN;
+    int cellCount;
+    int *fill;
+    PH_Tile *t;
+
+    Arena_release(world->tileCellStart, world->arena);
+    Arena_release(world->tileCellItems, world->arena);
+
+    //the grid covers the bounding box of the tiles
+    for(i = 0; i < world->tileCount; i++) {
+        t = &world->tiles[i];
+        minX = t->min[0] < minX ? t->min[0] : minX;
+        minY = t->min[1] < minY ? t->min[1] : minY;
+        maxX = t->max[0] > maxX ? t->max[0] : maxX;
+        maxY = t->max[1] > maxY ? t->max[1] : maxY;
+    }
+    world->tileOrigin[0] = minX;
+    world->tileOrigin[1] = minY;
+    world->tileCols = (maxX - minX) / PH_TILE_CELL_SIZE + 1;
+    world->tileRows = (maxY - minY) / PH_TILE_CELL_SIZE + 1;
+    cellCount = world->tileCols * world->tileRows;
+
+    //count the tiles in each cell, a tile is counted in every cell it overlaps, offset by one for the prefix sum
+    world->tileCellStart = (int*)Arena_callocTagged((size_t)cellCount + 1, sizeof(int), MT_TAG_PHYSICS, world->arena);
+    for(i = 0; i < world->tileCount; i++) {
+        t = &world->tiles[i];
+        for(y = (t->min[1] - minY) / PH_TILE_CELL_SIZE; y <= (t->max[1] - minY) / PH_TILE_CELL_SIZE; y++)
+            for(x = (t->min[0] - minX) / PH_TILE_CELL_SIZE; x <= (t->max[0] - minX) / PH_TILE_CELL_SIZE; x++)
+                world->tileCellStart[y * world->tileCols + x + 1]++;
+    }
+    for(c = 0; c < cellCount; c++)
+        world->tileCellStart[c + 1] += world->tileCellStart[c];
+
+    //fill the cells in tile order, so each cell lists its tiles in the order they were added
+    world->tileCellItems = (int*)Arena_allocTagged(sizeof(int) * (world->tileCellStart[cellCount] + 1), MT_TAG_PHYSICS,
+                                                   world->arena);
+    fill = (int*)MT_malloc(sizeof(int) * cellCount, MT_TAG_PHYSICS);
+    memcpy(fill, world->tileCellStart, sizeof(int) * cellCount);
+    for(i = 0; i < world->tileCount; i++) {
+        t = &world->tiles[i];
+        for(y = (t->min[1] - minY) / PH_TILE_CELL_SIZE; y <= (t->max[1] - minY) / PH_TILE_CELL_SIZE; y++)
+            for(x = (t->min[0] - minX) / PH_TILE_CELL_SIZE; x <= (t->max[0] - minX) / PH_TILE_CELL_SIZE; x++)
+                world->tileCellItems[fill[y * world->tileCols + x]++] = i;
+    }
+    MT_free(fill);
+
+    world->tileDirty = 0;
+}
+
+static inline void PH_tileAABB(const PH_Tile *t, AABB *a) {
+    a->center.x = (t->min[0] + t->max[0]) * 0.5f;
+    a->center.y = (t->min[1] + t->max[1]) * 0.5f;
+    a->hWidth = (t->max[0] - t->min[0]) * 0.5f;
+    a->hHeight = (t->max[1] - t->min[1]) * 0.5f;
+}
+
+void PH_testTiles(Object **objs, int count, World *world) {
+    int i, k, x, y, c;
+    int x0, y0, x1, y1, tx, ty;
+    float margin;
+    int cell = PH_TILE_CELL_SIZE;
+    const PH_Tile *t;
+    AABB *a;
+    PH_Manifold m;
+
+    if(world->tileCount == 0)
+        return;
+
+    for(i = 0; i < count; i++) {
+        a = &objs[i]->aabb;
+
+        //dynamic objects have to find the tiles within the contact skin too
+        margin = objs[i]->type == DYNAMIC ? PH_CONTACT_SKIN : 0;
+        x0 = (int)floorf((a->center.x - a->hWidth - margin - world->tileOrigin[0]) / cell);
+        y0 = (int)floorf((a->center.y - a->hHeight - margin - world->tileOrigin[1]) / cell);
+        x1 = (int)floorf((a->center.x + a->hWidth + margin - world->tileOrigin[0]) / cell);
+        y1 = (int)floorf((a->center.y + a->hHeight + margin - world->tileOrigin[1]) / cell);
+        if(x1 < 0 || y1 < 0 || x0 >= world->tileCols || y0 >= world->tileRows)
+            continue;
+        x0 = x0 < 0 ? 0 : x0;
+        y0 = y0 < 0 ? 0 : y0;
+        x1 = x1 >= world->tileCols ? world->tileCols - 1 : x1;
+        y1 = y1 >= world->tileRows ? world->tileRows - 1 : y1;
+
+        for(y = y0; y <= y1; y++)
+            for(x = x0; x <= x1; x++) {
+                c = y * world->tileCols + x;
+                for(k = world->tileCellStart[c]; k < world->tileCellStart[c + 1]; k++) {
+                    t = &world->tiles[world->tileCellItems[k]];
+
+                    //a tile is stored in every cell it overlaps, it is only tested in the first one the object covers
+                    tx = (t->min[0] - world->tileOrigin[0]) / cell;
+                    ty = (t->min[1] - world->tileOrigin[1]) / cell;
+                    if(x != (tx > x0 ? tx : x0) || y != (ty > y0 ? ty : y0))
+                        continue;
+
+                    PH_tileKernel(t, objs[i], world, &m);
+                }
+            }
+    }
+}
+
+static inline void PH_tileKernel(const PH_Tile *t, Object *B, World *world, PH_Manifold *m) {
+    AABB a;
+    PH_ContactBatch *batch = world->pairTable[t->type][B->userData.type];
+
+    PH_tileAABB(t, &a);
+    m->A = NULL;
+    m->B = B;
+    m->type = B->type == DYNAMIC ? TILE_DYNAMIC : TILE_HYBRID;
+    m->tile = t;
+
+    if(!(fabsf(a.center.x - B->aabb.center.x) < a.hWidth + B->aabb.hWidth &&
+         fabsf(a.center.y - B->aabb.center.y) < a.hHeight + B->aabb.hHeight)) {
+        //tiles are solid for dynamic objects, so being next to them is touching them
+        if(B->type == DYNAMIC && batch == NULL && PH_aabbProximity(&a, &B->aabb, m))
+            PH_recordContact(m);
+        return;
+    }
+
+    PH_aabbManifold(&a, &B->aabb, m);
+    if(batch != NULL) {
+        //same as with objects, handled pairs only generate contacts
+        PH_queueContact(m, world->pairSwap[t->type][B->userData.type], batch);
+    } else if(B->type == DYNAMIC) {
+        PH_resolveCollision(m);
+        PH_recordContact(m);
+    }
+}
+
+void PH_queueContact(PH_Manifold *m, int swap, PH_ContactBatch *batch) {
+    PH_Manifold *dest;
+
+    //grow the batch if needed, it keeps its size between steps
+    if(batch->count == batch->maxSize) {
+        int size = batch->maxSize ? batch->maxSize * 2 : 16;
+        batch->contacts = (PH_Manifold*)Arena_reallocTagged(batch->contacts, sizeof(PH_Manifold) * batch->maxSize,
+                                                            sizeof(PH_Manifold) * size, MT_TAG_PHYSICS, batch->arena);
+        batch->maxSize = size;
+    }
+
+    dest = &batch->contacts[batch->count++];
+    *dest = *m;
+
+    //the handler expects the objects in the order of the registration, so the normal flips too
+    if(swap) {
+        dest->A = m->B;
+        dest->B = m->A;
+        dest->n.x = -m->n.x;
+        dest->n.y = -m->n.y;
+    }
+}
+
+void PH_dispatchContacts(World *world) {
+    int i;
+    int elemCount = world->pairBatches->elemCount;
+    PH_ContactBatch **batches = (PH_ContactBatch**)world->pairBatches->vector;
+
+    //every handler gets all the contacts of its pair at once
+    for(i = 0; i < elemCount; i++) {
+        if(batches[i]->count != 0 && batches[i]->handler != NULL)
+            batches[i]->handler(batches[i]->contacts, batches[i]->count, batches[i]->state);
+        batches[i]->count = 0;
+    }
+}
+
+void PH_freeBatch(PH_ContactBatch *batch) {
+    MT_free(batch->contacts);
+    MT_free(batch);
+}
 
 
 /*
@@ -594,17 +1542,17 @@ void PH_resolveCollision(PH_Manifold *m) {
 void PH_resetForces(World *world) {
     //helper local variables
     int i;
-    int elemCount = world->dynObjBag->elemCount;
-    Object **objvector = (Object**)(world->dynObjBag->vector);
+    int elemCount = world->dynObjs.count;
+    Object **objvector = world->dynObjs.data;
 
     //reset dynamic objects' forces to gravity
     for(i=0;i<elemCount;i++){
-        objvector[i]->forceSum = VEC2D_scale(&(world->gravity), 1.0/objvector[i]->invMass);
+        objvector[i]->forceSum = VEC2D_scale(&(world->gravity), objvector[i]->mass);
     }
 
     //reset hybrid objects' forces to zero
-    elemCount = world->hybObjBag->elemCount;
-    objvector = (Object**)(world->hybObjBag->vector);
+    elemCount = world->hybObjs.count;
+    objvector = world->hybObjs.data;
     for(i=0; i<elemCount; i++) {
         objvector[i]->forceSum.x = 0;
         objvector[i]->forceSum.y = 0;
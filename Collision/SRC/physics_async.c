@@ -0,0 +1,337 @@
+/*
+* Copyright (C) 2015 Bendegúz Nagy
+* 
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+* 
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+* 
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../HEAD/physics_async.h"
+#include "../../Utility/HEAD/memtrack.h"
+
+/**@brief Number of commands the queue can hold.*/
+#define PH_CMD_QUEUE_SIZE (1024)
+/**@brief Number of commands popped from the queue at once.*/
+#define PH_CMD_BATCH (16)
+/**@brief Set in the shared snapshot index when the physics thread has published a snapshot not yet seen by the renderer.*/
+#define PH_SNAPSHOT_FRESH (4)
+/**@brief If the physics thread falls behind by more than this many seconds, it gives up catching up.*/
+#define PH_ASYNC_MAX_LAG (0.25)
+
+/**
+ * @brief Internal, the kinds of commands the queue can hold.
+ */
+typedef enum PH_CMD_TYPE {
+    PH_CMD_FORCE,
+    PH_CMD_IMPULSE,
+    PH_CMD_CALL
+} PH_CMD_TYPE;
+
+/**
+ * @brief Internal, a single command, the payload is copied into it.
+ */
+typedef struct PH_Command {
+    PH_CMD_TYPE type;
+    Object *obj;
+    PH_commandFunc func;
+    void *state;
+    union {
+        Vector2D vec;
+        double align; //makes the bytes safe to use for any data
+        unsigned char bytes[PH_CMD_DATA_SIZE];
+    } data;
+} PH_Command;
+
+/**
+ * @brief Internal, the render relevant state of every object after a tick.
+ */
+typedef struct PH_Snapshot {
+    SDL_Rect *rects;
+    SDL_Color *colors;
+    int count;
+    int maxSize;
+} PH_Snapshot;
+
+struct PH_AsyncWorld {
+    World *world;
+    PH_tickFunc tick;
+    PH_clockFunc clock;
+    void *state;
+
+    SDL_Thread *thread;
+    SDL_atomic_t running;
+
+    //the physics thread is the single consumer of the commands
+    SPSCRing commands;
+
+    //triple buffer, each thread owns one snapshot, the third one is exchanged through shared
+    PH_Snapshot snapshots[3];
+    int writeIndex; //owned by the physics thread
+    int readIndex; //owned by the rendering thread
+    SDL_atomic_t shared; //index of the exchanged snapshot, OR'd with PH_SNAPSHOT_FRESH
+};
+
+/**
+ * @brief Private, the function the physics thread runs.
+ */
+int PH_asyncThread(void *data);
+/**
+ * @brief Private, returns the time of the clock of the async world in µs.
+ */
+Uint64 PH_asyncNow(PH_AsyncWorld *aw);
+/**
+ * @brief Private, executes the queued commands, called from the physics thread.
+ */
+void PH_asyncExecute(PH_AsyncWorld *aw);
+/**
+ * @brief Private, fills the physics thread's snapshot and publishes it.
+ */
+void PH_asyncPublish(PH_AsyncWorld *aw);
+/**
+ * @brief Private, appends the objects in an array to a snapshot.
+ */
+void PH_snapshotObjects(ObjectArray *objs, PH_Snapshot *s);
+
+/**
+ * @brief Starts stepping a World on its own thread.
+ * @param world The World to be stepped, it belongs to the physics thread until PH_stopAsync().
+ * @param tick Called every step on the physics thread, responsible for stepping the world, can be NULL.
+ * @param clock The clock the steps are timed by, NULL for the wall clock.
+ * @param state State pointer passed to the tick function.
+ * @return The running async world, NULL if the thread could not be created.
+ */
+PH_AsyncWorld *PH_startAsync(World *world, PH_tickFunc tick, PH_clockFunc clock, void *state) {
+    PH_AsyncWorld *aw = (PH_AsyncWorld*)MT_calloc(1, sizeof(PH_AsyncWorld), MT_TAG_PHYSICS);
+    aw->world = world;
+    aw->tick = tick;
+    aw->clock = clock;
+    aw->state = state;
+
+    //the physics thread writes 0, the renderer reads 2, 1 is in between
+    aw->writeIndex = 0;
+    aw->readIndex = 2;
+    SDL_AtomicSet(&aw->shared, 1);
+    SDL_AtomicSet(&aw->running, 1);
+    SPSCRing_init(sizeof(PH_Command), PH_CMD_QUEUE_SIZE, &aw->commands);
+
+    if((aw->thread = SDL_CreateThread(&PH_asyncThread, "physics", aw)) == NULL) {
+        printf("FUNC: PH_startAsync. Error creating thread. SDL_ERROR: %s.\n", SDL_GetError());
+        SPSCRing_free(&aw->commands);
+        MT_free(aw);
+        return NULL;
+    }
+
+    return aw;
+}
+
+/**
+ * @brief Stops the physics thread and frees the async world, the World itself is not freed.
+ *
+ * After this returns, the World can be used from the calling thread again. Commands still in the queue are dropped.
+ */
+void PH_stopAsync(PH_AsyncWorld *aw) {
+    int i;
+    if(aw == NULL)
+        return;
+
+    SDL_AtomicSet(&aw->running, 0);
+    SDL_WaitThread(aw->thread, NULL);
+
+    for(i = 0; i < 3; i++) {
+        MT_free(aw->snapshots[i].rects);
+        MT_free(aw->snapshots[i].colors);
+    }
+    SPSCRing_free(&aw->commands);
+    MT_free(aw);
+}
+
+/**
+ * @brief Returns the id of the physics thread.
+ */
+SDL_threadID PH_asyncThreadID(PH_AsyncWorld *aw) {
+    return SDL_GetThreadID(aw->thread);
+}
+
+/**
+ * @brief Queues a force to be applied to an object before the next tick, see PH_force().
+ * @return non-zero if the queue is full.
+ */
+int PH_asyncForce(Vector2D force, Object *obj, PH_AsyncWorld *aw) {
+    PH_Command cmd;
+    cmd.type = PH_CMD_FORCE;
+    cmd.obj = obj;
+    cmd.data.vec = force;
+    return SPSCRing_push(&cmd, &aw->commands);
+}
+
+/**
+ * @brief Queues an impulse to be applied to an object before the next tick, see PH_impulse().
+ * @return non-zero if the queue is full.
+ */
+int PH_asyncImpulse(Vector2D impulse, Object *obj, PH_AsyncWorld *aw) {
+    PH_Command cmd;
+    cmd.type = PH_CMD_IMPULSE;
+    cmd.obj = obj;
+    cmd.data.vec = impulse;
+    return SPSCRing_push(&cmd, &aw->commands);
+}
+
+/**
+ * @brief Queues a function to be called on the physics thread before the next tick.
+ * @param func The function to be called.
+ * @param data Data copied into the command and passed to the function, can be NULL.
+ * @param size Size of the data, at most PH_CMD_DATA_SIZE.
+ * @param state State pointer passed to the function.
+ * @return non-zero if the queue is full or the data is too big.
+ */
+int PH_asyncCall(PH_commandFunc func, const void *data, size_t size, void *state, PH_AsyncWorld *aw) {
+    PH_Command cmd;
+    if(size > PH_CMD_DATA_SIZE)
+        return -1;
+
+    cmd.type = PH_CMD_CALL;
+    cmd.func = func;
+    cmd.state = state;
+    if(data != NULL)
+        memcpy(cmd.data.bytes, data, size);
+    return SPSCRing_push(&cmd, &aw->commands);
+}
+
+/**
+ * @brief Renders the latest snapshot published by the physics thread, relies on global gRenderer reference.
+ */
+void PH_renderAsync(PH_AsyncWorld *aw) {
+    PH_Snapshot *s;
+
+    //if there is a fresh snapshot, swap it with the one we have read last time
+    if(SDL_AtomicGet(&aw->shared) & PH_SNAPSHOT_FRESH)
+        aw->readIndex = SDL_AtomicSet(&aw->shared, aw->readIndex) & ~PH_SNAPSHOT_FRESH;
+
+    //the tiles never change once the World is handed over, so they can be read from here
+    PH_renderTiles(aw->world);
+
+    s = &aw->snapshots[aw->readIndex];
+    AABB_renderRects(s->rects, s->colors, s->count);
+}
+
+
+//private methods
+
+
+int PH_asyncThread(void *data) {
+    PH_AsyncWorld *aw = (PH_AsyncWorld*)data;
+    World *world = aw->world;
+    Uint64 stepUs = (Uint64)(world->stepTime * 1000000.0);
+    Uint64 maxLag = (Uint64)(PH_ASYNC_MAX_LAG * 1000000.0);
+    Uint64 next = PH_asyncNow(aw);
+    Uint64 now;
+
+    while(SDL_AtomicGet(&aw->running)) {
+        now = PH_asyncNow(aw);
+
+        //not time for the next tick yet, give the cpu away
+        if(now < next) {
+            SDL_Delay(1);
+            continue;
+        }
+
+        //we have fallen too much behind the wall clock, don't try to catch up, that would be a spiral of death
+        //a virtual clock may run ahead on purpose, every step it has passed has to be simulated
+        if(aw->clock == NULL && now - next > maxLag)
+            next = now;
+
+        PH_asyncExecute(aw);
+
+        if(aw->tick != NULL)
+            aw->tick(world, world->stepTime, aw->state);
+        else
+            PH_stepWorld(world->stepTime, world);
+
+        PH_asyncPublish(aw);
+        next += stepUs;
+    }
+
+    return 0;
+}
+
+Uint64 PH_asyncNow(PH_AsyncWorld *aw) {
+    static Uint64 freq = 0;
+    Uint64 counter;
+
+    if(aw->clock != NULL)
+        return aw->clock();
+
+    if(freq == 0)
+        freq = SDL_GetPerformanceFrequency();
+    counter = SDL_GetPerformanceCounter();
+    return counter / freq * 1000000 + counter % freq * 1000000 / freq;
+}
+
+void PH_asyncExecute(PH_AsyncWorld *aw) {
+    PH_Command batch[PH_CMD_BATCH];
+    PH_Command *cmd;
+    int i, count;
+    //only the commands pushed before the tick started are executed, a busy producer can't hold up the tick
+    int left = SPSCRing_count(&aw->commands);
+
+    while(left > 0 && (count = SPSCRing_popN(batch, left < PH_CMD_BATCH ? left : PH_CMD_BATCH, &aw->commands)) > 0) {
+        left -= count;
+        for(i = 0; i < count; i++) {
+            cmd = &batch[i];
+            switch (cmd->type) {
+                case PH_CMD_FORCE:
+                    PH_force(&cmd->data.vec, cmd->obj);
+                    break;
+                case PH_CMD_IMPULSE:
+                    PH_impulse(&cmd->data.vec, cmd->obj);
+                    break;
+                case PH_CMD_CALL:
+                    cmd->func(aw->world, cmd->data.bytes, cmd->state);
+                    break;
+            }
+        }
+    }
+}
+
+void PH_asyncPublish(PH_AsyncWorld *aw) {
+    PH_Snapshot *s = &aw->snapshots[aw->writeIndex];
+    s->count = 0;
+
+    PH_snapshotObjects(&aw->world->stObjs, s);
+    PH_snapshotObjects(&aw->world->dynObjs, s);
+    PH_snapshotObjects(&aw->world->hybObjs, s);
+
+    //hand over our snapshot, take the one the renderer is done with
+    aw->writeIndex = SDL_AtomicSet(&aw->shared, aw->writeIndex | PH_SNAPSHOT_FRESH) & ~PH_SNAPSHOT_FRESH;
+}
+
+void PH_snapshotObjects(ObjectArray *objs, PH_Snapshot *s) {
+    int i;
+    int elemCount = objs->count; //cache the array's element count
+    Object **objVector = objs->data; //cache the array's storage
+
+    //make room for every object, snapshots only ever grow
+    if(s->count + elemCount > s->maxSize) {
+        s->maxSize = (s->count + elemCount) * 2;
+        s->rects = (SDL_Rect*)MT_realloc(s->rects, sizeof(SDL_Rect) * s->maxSize, MT_TAG_PHYSICS);
+        s->colors = (SDL_Color*)MT_realloc(s->colors, sizeof(SDL_Color) * s->maxSize, MT_TAG_PHYSICS);
+    }
+
+    for(i = 0; i < elemCount; i++) {
+        s->rects[s->count] = AABB_toRect(&objVector[i]->aabb);
+        s->colors[s->count] = objVector[i]->color;
+        s->count++;
+    }
+}
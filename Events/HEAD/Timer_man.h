@@ -20,17 +20,24 @@
  * @brief Module for handling timed events, built upon Timer objects.
  * @author Bendegúz Nagy
  *
- * This module maintains an ordered list of timed events, which consists of
- * Timer_callBack function pointers, their state pointers. Also each one is assigned
- * a Timer object.
+ * This module maintains timed events, which consist of Timer_callBack function pointers, their state pointers and
+ * a Timer object each.
  *
  * Initialize and deinitialize the module with TM_init() and TM_deinit() respectively.
- * Register Timed_events with TM_new(), free them with TM_freeTimed_event().
- * Note: A Timed_event is destroyed automatically, if during a callback it returns a
- * non-zero constant.
- * Call TM_process() with the elapsed time in ms, which calls each registered Timed_event
- * with the elapsed time.
+ * Register events called every TM_process() with TM_new(), and events called once a given time has passed with
+ * TM_newDelayed(). A Timed_event is destroyed, if during a callback it returns a non-zero constant, or if it is
+ * cancelled with TM_cancel(), from anywhere, even during a callback. Events are referred to by the generational Handle
+ * they are created with, TM_isAlive() tells in O(1) if the event still exists.
+ * Call TM_process() with the elapsed time in ms, which calls the events which are due with the elapsed time.
+ * TM_processUs() takes the elapsed time in µs, the events still count in whole ms, the rest is carried over to the
+ * next call, so a clock finer than a ms doesn't make the events drift.
  * Destroy every Timed_event with TM_clear().
+ * The events are processed only on the thread set with TM_setOwner(), by default the one that called TM_init().
+ *
+ * The delayed events are kept in a hierarchical timing wheel with ms resolution, so a TM_process() only touches the
+ * events which are due, creating and cancelling events is O(1). The lowest level of the wheel holds the events due in
+ * the next 64 ms, each level above covers 64 times the time of the one below it, with slots as many times coarser. When
+ * a level wraps around, the next slot of the level above it is spread over it.
  *
  */
 
@@ -40,6 +47,7 @@
 
 #include "../HEAD/Timer_man.h"
 #include "timer.h"
+#include "../../Utility/HEAD/handle.h"
 
 /**
  * @brief Timed_event function pointers have to adhere to this signature.
@@ -51,22 +59,33 @@
 typedef int (*Timer_callBack)(Uint32 delta, Timer *timer, void *state);
 
 
+/**
+ * @brief A registered event, do not access the fields directly.
+ */
 typedef struct Timed_event {
-    int id; //used for direct access from the array, do not modify
-    Timer *timer;
+    Timer timer;
     Timer_callBack callBack;
     void *state;
+    Handle handle;
+    Uint32 period; //the delay of a delayed event, 0 for events called every TM_process()
+    Uint32 deadline; //the tick the delayed event is due at
+    int list; //the list the event is linked into, -1 if none
+    int prev, next; //the neighbours in the list, -1 at the ends
 } Timed_event;
 
 void TM_init();
 void TM_deinit();
 
 
-Timed_event *TM_new(Timer_callBack callBack, void *state);
-void TM_freeTimed_event(Timed_event *e);
+Handle TM_new(Timer_callBack callBack, void *state);
+Handle TM_newDelayed(Uint32 delay, Timer_callBack callBack, void *state);
+int TM_cancel(Handle event);
+int TM_isAlive(Handle event);
 
 
+void TM_setOwner(SDL_threadID id);
 void TM_process(Uint32 delta);
+void TM_processUs(Uint64 delta);
 void TM_clear();
 
 #endif //DUMMY_TIMER_MAN_H
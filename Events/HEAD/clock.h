@@ -0,0 +1,68 @@
+/*
+* Copyright (C) 2015 Bendegúz Nagy
+* 
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+* 
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+* 
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file
+ * @brief The virtual clock the game takes its time from, decoupled from the wall clock.
+ * @author Bendegúz Nagy
+ *
+ * The main loop advances the clock once per frame with Clock_tick(), which returns the virtual time the frame lasted
+ * in µs, everything simulated is driven by that delta. Clock_now() returns the virtual time since the start, it can be
+ * read from any thread. The CLOCK_MODE decides how virtual time relates to the wall clock:
+ *
+ * CLOCK_MODE_REALTIME follows the wall clock.
+ * CLOCK_MODE_SCALED follows the wall clock multiplied by the scale set with Clock_setScale(), below 1 is slow motion.
+ * CLOCK_MODE_FIXED_STEP advances by the step set with Clock_setStep() every frame, so runs are repeatable, and waits
+ * if the frame was shorter than the step, so it still runs at real speed.
+ * CLOCK_MODE_FAST advances by the step every frame without waiting, the game runs as fast as the cpu allows.
+ * Rendering is only needed a few times a wall clock second, Clock_shouldRender() tells when.
+ *
+ * In the real time modes a single frame never lasts longer than CLOCK_MAX_DELTA, a stall (like a breakpoint or a
+ * dragged window) doesn't turn into a huge step.
+ */
+
+#ifndef DUMMY_CLOCK_H
+#define DUMMY_CLOCK_H
+
+#include <SDL2/SDL.h>
+
+/**@brief The longest frame in µs the real time modes return.*/
+#define CLOCK_MAX_DELTA (250000)
+/**@brief The default step in µs of the fixed step modes.*/
+#define CLOCK_DEFAULT_STEP (16667)
+/**@brief How often CLOCK_MODE_FAST renders, in wall clock µs.*/
+#define CLOCK_RENDER_INTERVAL (100000)
+
+/**
+ * @brief How the virtual clock advances.
+ */
+typedef enum CLOCK_MODE {
+    CLOCK_MODE_REALTIME,
+    CLOCK_MODE_SCALED,
+    CLOCK_MODE_FIXED_STEP,
+    CLOCK_MODE_FAST
+} CLOCK_MODE;
+
+void Clock_setMode(CLOCK_MODE mode);
+CLOCK_MODE Clock_getMode();
+void Clock_setScale(double scale);
+void Clock_setStep(Uint64 step);
+Uint64 Clock_tick();
+Uint64 Clock_now();
+int Clock_shouldRender();
+
+#endif //DUMMY_CLOCK_H
@@ -25,10 +25,32 @@
  * registered inputConsumers. If one of those functions returns non-zero, then the SDL_Event is considered
  * consumed and will not be passed to successive functions in the list.
  *
+ * Key events can also be routed straight to their owner: Input_bindKey() binds an SDL_Keycode to a keyConsumer
+ * with an action and a state pointer, Input_unbindKey() removes the binding. The bindings are kept in a hash table,
+ * so delivering a key event costs the same however many keys are bound. A bound key event is only passed down the
+ * inputConsumer list if its keyConsumer returns 0, unbound key events and every other event go down the list.
+ *
+ * The input can be recorded into a file and played back from it. Input_startRecording() writes every event taken by
+ * Input_process() and the delta of every frame into a compact binary stream, Input_startPlayback() feeds them back
+ * through the same route and list instead of SDL_PollEvent(), while SDL_QUIT still comes from SDL. The frames are
+ * marked by Input_beginFrame(), call it once per frame before Input_process(), during playback it returns the recorded
+ * delta instead of the measured one. The stream also holds the seed of rand(), so with the game simulated on the main
+ * thread a recorded match plays back exactly the same. When the recorded input runs out, playback ends with an
+ * SDL_QUIT event. Input_stopStream() closes the stream, Input_isPlaying() tells if a playback is running.
+ *
+ * By default the events are only taken from SDL once per frame, when Input_process() is called, so a long frame
+ * delays them and they all look like they have happened at the start of the next one. Input_startThread() starts a
+ * thread which pumps the events of SDL every ms, stamps them with the wall clock time and passes them to
+ * Input_process() through a lock-free queue. While a consumer is called, Input_eventOffset() tells when its event has
+ * happened, mapped onto the delta of the frame, so the game can apply it at the step it belongs to. The offsets are
+ * recorded too. Input_eventTime() returns the wall clock time the event was taken at, with or without the thread.
+ * SDL only lets other threads pump the events on some platforms (X11, Wayland), elsewhere the thread sees none of
+ * them, keep it off there. Input_stopThread() stops the thread.
+ *
  * Initialize the module with Input_init(), deinitialize with Input_deinit().
  * When you wish to process the events accumulated in SDL, call Input_process().
  * Register inputConsumers with Input_subscribe().
- * To empty the maintained list, call Input_clear().
+ * To empty the maintained list and the key bindings, call Input_clear().
  */
 
 #ifndef DUMMY_INPUT_H
@@ -43,6 +65,15 @@
  */
 typedef int (*inputConsumer)(SDL_Event *e, void *state);
 
+/**
+ * @brief Functions bound to keys have to adhere to this signature.
+ * @param e Pointer to the SDL_KEYDOWN or SDL_KEYUP event of the key.
+ * @param action The action the key has been bound with.
+ * @param state Optional state pointer set when the key was bound.
+ * @return 1 if the event should be considered consumed, 0 if it should be passed down the inputConsumer list.
+ */
+typedef int (*keyConsumer)(SDL_Event *e, int action, void *state);
+
 
 
 void Input_init();
@@ -50,8 +81,21 @@ void Input_deinit();
 
 
 void Input_subscribe(inputConsumer cons, void *state);
+void Input_bindKey(SDL_Keycode key, keyConsumer cons, int action, void *state);
+void Input_unbindKey(SDL_Keycode key);
 void Input_process();
 
+int Input_startRecording(const char *path, Uint32 seed);
+int Input_startPlayback(const char *path, Uint32 *seed);
+void Input_stopStream();
+int Input_isPlaying();
+Uint64 Input_beginFrame(Uint64 delta);
+Uint64 Input_eventOffset();
+Uint64 Input_eventTime();
+
+int Input_startThread();
+void Input_stopThread();
+
 
 void Input_clear();
 
@@ -0,0 +1,105 @@
+/*
+* Copyright (C) 2015 Bendegúz Nagy
+* 
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+* 
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+* 
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file
+ * @brief Stackless coroutines for timed sequences of logic, run by the timed events.
+ * @author Bendegúz Nagy
+ *
+ * A Task runs a Task_func, which can stop in the middle and continue from there later, so a sequence like "dash for
+ * 50 ms, then restore the caps" can be written as a single function:
+ *
+ *      int Player_dashTask(Task *task, Uint32 delta, void *player) {
+ *          TASK_BEGIN(task);
+ *          while (task->elapsed <= DASH_DURR) {
+ *              ...
+ *              TASK_YIELD(task);
+ *          }
+ *          ...
+ *          TASK_END(task);
+ *      }
+ *
+ * TASK_YIELD() continues the function at the next TM_process(), TASK_WAIT() once the given ms have passed. The Task
+ * only remembers where the function has to continue, local variables lose their values at every yield and wait, so
+ * anything that has to be kept goes into the state or the Task. The macros expand to a switch, the body of the
+ * function can't have switches yielding or waiting inside them.
+ *
+ * Tasks are stored by value, typically inside the object they work on, and are resumed by the timed events of the
+ * Timer_man module, which are pooled, so running a Task allocates nothing. Initialize a Task with Task_init(), start it
+ * with Task_start(), which runs the function up to its first yield or wait. Task_stop() stops it, this has to be
+ * called before the memory of a running Task is freed. A Task must not start or stop itself from its own function,
+ * it can end with TASK_EXIT().
+ */
+
+#ifndef DUMMY_TASK_H
+#define DUMMY_TASK_H
+
+#include "Timer_man.h"
+
+/**
+ * @brief What a Task_func returns, the macros take care of it.
+ */
+typedef enum TASK_STATUS {
+    TASK_DONE,
+    TASK_YIELDED,
+    TASK_WAITING
+} TASK_STATUS;
+
+typedef struct Task Task;
+
+/**
+ * @brief Task functions have to adhere to this signature.
+ * @param task The Task running the function.
+ * @param delta The delta of the TM_process() resuming the Task, 0 when it is started.
+ * @param state The state pointer passed to Task_start().
+ * @return a TASK_STATUS, returned by the macros.
+ */
+typedef int (*Task_func)(Task *task, Uint32 delta, void *state);
+
+/**
+ * @brief A running Task_func, the fields are only to be read by the function.
+ */
+struct Task {
+    Task_func func;
+    void *state;
+    int line; //where the function continues, 0 at the start
+    Uint32 elapsed; //ms since the Task was started, updated before the function is resumed
+    Uint32 wait; //ms of the current wait, 0 if the Task yielded
+    Handle event; //the timed event resuming the Task
+};
+
+/**@brief Starts the body of a Task_func.*/
+#define TASK_BEGIN(task) switch ((task)->line) { case 0:
+/**@brief Ends the body of a Task_func, the Task is done.*/
+#define TASK_END(task) } (task)->line = 0; return TASK_DONE
+/**@brief Ends the Task from anywhere in the body.*/
+#define TASK_EXIT(task) do { (task)->line = 0; return TASK_DONE; } while (0)
+/**@brief Continues the Task at the next TM_process().*/
+#define TASK_YIELD(task) do { (task)->line = __LINE__; return TASK_YIELDED; case __LINE__:; } while (0)
+/**@brief Continues the Task once ms have passed.*/
+#define TASK_WAIT(task, ms) \
+    do { (task)->line = __LINE__; (task)->wait = (ms); return TASK_WAITING; case __LINE__:; } while (0)
+/**@brief Checks the condition at every TM_process(), continues once it is true.*/
+#define TASK_WAIT_UNTIL(task, cond) \
+    do { (task)->line = __LINE__; case __LINE__: if (!(cond)) return TASK_YIELDED; } while (0)
+
+void Task_init(Task *task);
+void Task_start(Task_func func, void *state, Task *task);
+void Task_stop(Task *task);
+int Task_isRunning(Task *task);
+
+#endif //DUMMY_TASK_H
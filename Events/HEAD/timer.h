@@ -25,9 +25,11 @@
  * had no use for more.
  *
  * It also features a function getDelta(), which will return the number of ticks
- * passed since it was called.
+ * passed since it was called. getTimeUs() is a monotonic clock in µs built on the performance counter,
+ * getDeltaUs() returns the µs passed since it was last called, for loops which can't afford whole ms.
  *
- * Create the objects with Timer_new(), destroy them with Timer_free().
+ * Create the objects with Timer_new(), destroy them with Timer_free(). Timers can also be stored by value,
+ * Timer_start() initializes them.
  * Start them with Timer_start(), they won't accept ticks if they hadn't been started.
  * Update them with Timer_updateDelta(), retrieve their time with Timer_getTicks().
  *
@@ -39,9 +41,17 @@
 #include <SDL2/SDL.h>
 
 Uint32 getDelta();
+Uint64 getTimeUs();
+Uint64 getDeltaUs();
 
 
-typedef struct Timer Timer;
+/**
+ * @brief Time-keeping object, do not access the fields directly.
+ */
+typedef struct Timer {
+    Uint32 ticksRunning;
+    int isStarted;
+} Timer;
 
 Timer *Timer_new();
 void Timer_free(Timer *ptr);
@@ -15,49 +15,152 @@
 * along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <stdint.h>
 #include "../HEAD/Timer_man.h"
-#include "../../Utility/HEAD/bag.h"
+#include "../../Utility/HEAD/array.h"
 
+/**@brief Number of bits of the slot index of a wheel level.*/
+#define TM_WHEEL_BITS (6)
+#define TM_WHEEL_SLOTS (1 << TM_WHEEL_BITS)
+#define TM_WHEEL_MASK (TM_WHEEL_SLOTS - 1)
+/**@brief Number of levels, delays up to 2^24 ms (4.6 hours) fit, longer ones are placed again when they get closer.*/
+#define TM_WHEEL_LEVELS (4)
+/**@brief The list of the events called every TM_process(), it comes after the slots of the wheel.*/
+#define TM_FRAME_LIST (TM_WHEEL_LEVELS * TM_WHEEL_SLOTS)
+/**@brief The events of the frame list set aside while the wheel is processed, the ones created meanwhile wait.*/
+#define TM_FRAME_SNAPSHOT (TM_FRAME_LIST + 1)
+/**@brief The list of the events being processed.*/
+#define TM_FIRING_LIST (TM_FRAME_SNAPSHOT + 1)
+#define TM_LIST_COUNT (TM_FIRING_LIST + 1)
+
+DEFINE_ARRAY(Timed_event, Timed_eventArray)
+
+/**
+ * @brief Internal, holds the events, indexed by the slot index of their Handles.
+ */
+static Timed_eventArray events;
+/**
+ * @brief Internal, tracks which events are alive.
+ */
+static HandleTable eventHandles;
+/**
+ * @brief Internal, the first and the last event of each list, -1 if the list is empty.
+ */
+static int heads[TM_LIST_COUNT];
+static int tails[TM_LIST_COUNT];
+/**
+ * @brief Internal, the next ms to be processed, the clock of the delayed events.
+ */
+static Uint32 nextTick = 0;
+/**
+ * @brief Internal, the number of events in the wheel, while it is empty the ticks are skipped.
+ */
+static int wheelCount = 0;
+/**
+ * @brief Internal, the µs passed to TM_processUs() which don't add up to a whole ms yet.
+ */
+static Uint32 usRemainder = 0;
+/**
+ * @brief Internal, id of the thread allowed to process the events, stored as a pointer so it can be swapped atomically.
+ */
+static void *owner = NULL;
+
+/**
+ * @brief Private, creates an event without linking it into any list.
+ * @return the index of the event, -1 if there is no more room.
+ */
+int TM_alloc(Timer_callBack callBack, void *state);
+/**
+ * @brief Private, appends an event to the end of a list.
+ */
+void TM_link(int index, int list);
+/**
+ * @brief Private, takes an event out of its list, if it is in one.
+ */
+void TM_unlink(int index);
+/**
+ * @brief Private, moves every event of a list into another, empty, list.
+ */
+void TM_moveList(int list, int to);
+/**
+ * @brief Private, links a delayed event into the wheel slot of its deadline.
+ */
+void TM_schedule(int index);
+/**
+ * @brief Private, processes the next ms of the wheel.
+ */
+void TM_tick(Uint32 delta);
 /**
- * @brief Internal list holding the Timed_events.
+ * @brief Private, calls an event taken out of its list, then destroys it or links it back.
  */
-static Bag *eventStack = NULL;
+void TM_fire(int index, Uint32 delta);
 
 /**
- * @brief Create a new timed event and register it.
+ * @brief Create a new timed event called every TM_process() and register it.
  * @param callBack The callback function.
  * @param state The state function which will be passed to the function with each function.
- * @return Returns the newly allocated Timed_event.
+ *
+ * @return the Handle of the event.
+ *
+ * The event lives until its callback returns non-zero during a TM_process(), until it is cancelled, or until TM_clear().
+ * Use this only for events which have to do something every frame, TM_newDelayed() events cost nothing until they are
+ * due.
  */
-Timed_event *TM_new(Timer_callBack callBack, void *state)
+Handle TM_new(Timer_callBack callBack, void *state)
 {
-    Timed_event *e = (Timed_event *) malloc(sizeof(Timed_event));
-    e->callBack = callBack;
-    e->state = state;
-    e->timer = Timer_new();
-    Timer_start(e->timer);
+    int index = TM_alloc(callBack, state);
+    if (index == -1)
+        return HANDLE_NULL;
 
-    //set the index at which this timed event is stored
-    e->id = eventStack->elemCount;
-    Bag_push(e, eventStack);
+    TM_link(index, TM_FRAME_LIST);
+    return events.data[index].handle;
+}
 
-    return e;
+/**
+ * @brief Create a new timed event called once a given time has passed and register it.
+ * @param delay The time in ms until the event is due, at least 1.
+ * @param callBack The callback function, it gets the delta of the TM_process() and a Timer holding the delay.
+ * @param state The state function which will be passed to the function with each function.
+ *
+ * @return the Handle of the event.
+ *
+ * The event is called by the TM_process() during which delay ms have passed since its creation. If the callback
+ * returns 0, the event is called again delay ms after its previous deadline, until it returns non-zero.
+ */
+Handle TM_newDelayed(Uint32 delay, Timer_callBack callBack, void *state)
+{
+    int index = TM_alloc(callBack, state);
+    if (index == -1)
+        return HANDLE_NULL;
+
+    events.data[index].period = delay != 0 ? delay : 1;
+    events.data[index].deadline = nextTick + events.data[index].period - 1;
+    TM_schedule(index);
+    return events.data[index].handle;
 }
 
 /**
- * @brief Deallocate a Timed_event, this can also be done automatically.
- * @param e The event to be destroyed.
+ * @brief Destroys an event, its callback will not be called any more.
+ * @return non-zero if the event was still alive.
  *
- * Deallocate a Timed_event, note that if during a TM_process() an event's callback
- * function returns non-zero, it will be automatically deleted.
+ * Can be called from a callback, even for the event being processed, its return value is then ignored.
  */
-void TM_freeTimed_event(Timed_event *e)
+int TM_cancel(Handle event)
 {
-    Bag_unorderedRemove(e->id, eventStack);
-    if (eventStack->vector[e->id] != NULL)
-        ((Timed_event *) (eventStack->vector[e->id]))->id = e->id;
-    Timer_free(e->timer);
-    free(e);
+    if (!HandleTable_remove(event, &eventHandles))
+        return 0;
+
+    //an event being processed is in no list
+    TM_unlink(HANDLE_INDEX(event));
+    return 1;
+}
+
+/**
+ * @brief Tells if an event is still alive.
+ */
+int TM_isAlive(Handle event)
+{
+    return HandleTable_isValid(event, &eventHandles);
 }
 
 /**
@@ -68,7 +171,10 @@ void TM_freeTimed_event(Timed_event *e)
  */
 void TM_init()
 {
-    eventStack = Bag_new((freeData) &TM_freeTimed_event);
+    Timed_eventArray_initTagged(MT_TAG_TIMER, NULL, &events);
+    HandleTable_initTagged(MT_TAG_TIMER, NULL, &eventHandles);
+    TM_clear();
+    TM_setOwner(SDL_ThreadID());
 }
 
 /**
@@ -76,7 +182,8 @@ void TM_init()
  */
 void TM_deinit()
 {
-    Bag_free(eventStack, 1);
+    Timed_eventArray_free(&events);
+    HandleTable_free(&eventHandles);
 }
 
 /**
@@ -84,23 +191,228 @@ void TM_deinit()
  */
 void TM_clear()
 {
-    TM_deinit();
-    TM_init();
+    int i;
+
+    //the handles of the old events must stay stale, the events themselves are overwritten when their slots are reused
+    HandleTable_clear(&eventHandles);
+    for (i = 0; i < TM_LIST_COUNT; i++)
+        heads[i] = tails[i] = -1;
+    wheelCount = 0;
+}
+
+/**
+ * @brief Hand the module over to another thread.
+ * @param id The id of the thread allowed to process the Timed_events.
+ *
+ * TM_process() calls made from any other thread are ignored, this makes it possible to run the
+ * game logic on a different thread, without touching the main loop. TM_init() sets the owner to
+ * the calling thread.
+ */
+void TM_setOwner(SDL_threadID id)
+{
+    SDL_AtomicSetPtr(&owner, (void *) (uintptr_t) id);
 }
 
 /**
  * @brief Process the Timed_events with the elapsed time passed in ms.
  * @param delta Elapsed time since the last call in ms.
+ *
+ * The delayed events which are due are called first, in the order of their deadlines, then every event registered
+ * with TM_new(). Events created by the callbacks are not called before the next TM_process().
  */
 void TM_process(Uint32 delta)
 {
-    int i;
-    Timed_event *e;
-    for (i = 0; i < eventStack->elemCount; i++) {
-        e = eventStack->vector[i];
-        //if the return value is not 0, means the timer wants itself deleted
-        if (e->callBack(delta, e->timer, e->state) != 0) {
-            TM_freeTimed_event(e);
+    Uint32 i;
+    int index;
+
+    //the events belong to another thread
+    if ((SDL_threadID) (uintptr_t) SDL_AtomicGetPtr(&owner) != SDL_ThreadID())
+        return;
+
+    //the per-frame events created by the delayed callbacks wait for the next call
+    TM_moveList(TM_FRAME_LIST, TM_FRAME_SNAPSHOT);
+    for (i = 0; i < delta; i++) {
+        //no event can be due, the clock can jump
+        if (wheelCount == 0) {
+            nextTick += delta - i;
+            break;
         }
+        TM_tick(delta);
+    }
+
+    TM_moveList(TM_FRAME_SNAPSHOT, TM_FIRING_LIST);
+    while ((index = heads[TM_FIRING_LIST]) != -1) {
+        TM_unlink(index);
+        TM_fire(index, delta);
+    }
+}
+
+/**
+ * @brief Process the Timed_events with the elapsed time passed in µs.
+ * @param delta Elapsed time since the last call in µs.
+ *
+ * Works like TM_process() with the whole ms, what is left of a ms is added to the next call.
+ */
+void TM_processUs(Uint64 delta)
+{
+    Uint64 total;
+
+    //the events belong to another thread, so does the remainder
+    if ((SDL_threadID) (uintptr_t) SDL_AtomicGetPtr(&owner) != SDL_ThreadID())
+        return;
+
+    total = usRemainder + delta;
+    usRemainder = (Uint32) (total % 1000);
+    TM_process((Uint32) (total / 1000));
+}
+
+
+//private methods
+
+
+int TM_alloc(Timer_callBack callBack, void *state)
+{
+    Timed_event e;
+    Handle handle = HandleTable_add(NULL, &eventHandles);
+    int index = HANDLE_INDEX(handle);
+
+    if (handle == HANDLE_NULL)
+        return -1;
+
+    e.callBack = callBack;
+    e.state = state;
+    e.handle = handle;
+    e.period = e.deadline = 0;
+    e.list = e.prev = e.next = -1;
+    Timer_start(&e.timer);
+
+    //the table hands out new slots in order, so a new slot is always the next element of the array
+    if (index == events.count)
+        Timed_eventArray_push(e, &events);
+    else
+        events.data[index] = e;
+    return index;
+}
+
+void TM_link(int index, int list)
+{
+    Timed_event *e = &events.data[index];
+
+    e->list = list;
+    e->prev = tails[list];
+    e->next = -1;
+    if (tails[list] == -1)
+        heads[list] = index;
+    else
+        events.data[tails[list]].next = index;
+    tails[list] = index;
+
+    if (list < TM_FRAME_LIST)
+        wheelCount++;
+}
+
+void TM_unlink(int index)
+{
+    Timed_event *e = &events.data[index];
+
+    if (e->list == -1)
+        return;
+
+    if (e->prev == -1)
+        heads[e->list] = e->next;
+    else
+        events.data[e->prev].next = e->next;
+    if (e->next == -1)
+        tails[e->list] = e->prev;
+    else
+        events.data[e->next].prev = e->prev;
+
+    if (e->list < TM_FRAME_LIST)
+        wheelCount--;
+    e->list = e->prev = e->next = -1;
+}
+
+void TM_moveList(int list, int to)
+{
+    int index;
+
+    heads[to] = heads[list];
+    tails[to] = tails[list];
+    heads[list] = tails[list] = -1;
+
+    for (index = heads[to]; index != -1; index = events.data[index].next) {
+        events.data[index].list = to;
+        if (list < TM_FRAME_LIST)
+            wheelCount--;
+    }
+}
+
+void TM_schedule(int index)
+{
+    Uint32 due = events.data[index].deadline;
+    Uint32 ahead = due - nextTick;
+    int level = 0;
+
+    //overdue events are processed with the next tick
+    if ((int32_t) ahead < 0)
+        due = nextTick, ahead = 0;
+    //too far for the wheel, it is placed as far as possible and placed again from there
+    if (ahead >> (TM_WHEEL_LEVELS * TM_WHEEL_BITS) != 0)
+        due = nextTick + (1u << (TM_WHEEL_LEVELS * TM_WHEEL_BITS)) - 1, ahead = due - nextTick;
+
+    while (level < TM_WHEEL_LEVELS - 1 && ahead >> ((level + 1) * TM_WHEEL_BITS) != 0)
+        level++;
+    TM_link(index, level * TM_WHEEL_SLOTS + (int) ((due >> (level * TM_WHEEL_BITS)) & TM_WHEEL_MASK));
+}
+
+void TM_tick(Uint32 delta)
+{
+    Uint32 tick = nextTick;
+    int level = 0, slot, index;
+
+    //when a level wraps around, the next slot of the level above it is spread over it
+    while (level < TM_WHEEL_LEVELS - 1 && ((tick >> (level * TM_WHEEL_BITS)) & TM_WHEEL_MASK) == 0) {
+        level++;
+        slot = level * TM_WHEEL_SLOTS + (int) ((tick >> (level * TM_WHEEL_BITS)) & TM_WHEEL_MASK);
+        while ((index = heads[slot]) != -1) {
+            TM_unlink(index);
+            TM_schedule(index);
+        }
+    }
+
+    //events created by the callbacks belong to the following ticks, even if they land in this slot
+    nextTick++;
+    TM_moveList((int) (tick & TM_WHEEL_MASK), TM_FIRING_LIST);
+    while ((index = heads[TM_FIRING_LIST]) != -1) {
+        TM_unlink(index);
+        TM_fire(index, delta);
+    }
+}
+
+void TM_fire(int index, Uint32 delta)
+{
+    //the callback gets a copy, it may register new events, which can move the array
+    Timed_event e = events.data[index];
+
+    if (e.period != 0) {
+        Timer_start(&e.timer);
+        Timer_updateDelta(e.period, &e.timer);
+    }
+
+    //if the return value is not 0, the event wants itself deleted
+    if (e.callBack(delta, &e.timer, e.state) != 0) {
+        HandleTable_remove(e.handle, &eventHandles);
+        return;
+    }
+    //cancelled during the callback, its slot may hold a new event by now
+    if (!HandleTable_isValid(e.handle, &eventHandles))
+        return;
+
+    events.data[index].timer = e.timer;
+    if (e.period == 0) {
+        TM_link(index, TM_FRAME_LIST);
+    } else {
+        events.data[index].deadline += e.period;
+        TM_schedule(index);
     }
 }
@@ -0,0 +1,164 @@
+/*
+* Copyright (C) 2015 Bendegúz Nagy
+* 
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+* 
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+* 
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "../HEAD/clock.h"
+#include "../HEAD/timer.h"
+
+/**
+ * @brief Internal, the mode and the settings of the clock.
+ */
+static CLOCK_MODE mode = CLOCK_MODE_REALTIME;
+static double scale = 1.0;
+static Uint64 step = CLOCK_DEFAULT_STEP;
+/**
+ * @brief Internal, the virtual time since the start in µs, guarded by nowLock, so other threads can read it.
+ */
+static Uint64 now = 0;
+static SDL_SpinLock nowLock = 0;
+/**
+ * @brief Internal, the fraction of a µs the scaled mode could not yet return.
+ */
+static double scaledRemainder = 0;
+/**
+ * @brief Internal, the wall clock time the next fixed step frame may start at, 0 if pacing has to start over.
+ */
+static Uint64 paceNext = 0;
+/**
+ * @brief Internal, the wall clock time of the last frame CLOCK_MODE_FAST has rendered.
+ */
+static Uint64 lastRender = 0;
+
+/**
+ * @brief Private, waits until the wall clock has caught up with the fixed step frames.
+ */
+void Clock_pace();
+
+/**
+ * @brief Sets how the clock advances from the next Clock_tick() on, the virtual time itself doesn't jump.
+ */
+void Clock_setMode(CLOCK_MODE m) {
+    mode = m;
+    scaledRemainder = 0;
+    paceNext = 0;
+}
+
+/**
+ * @brief Returns how the clock advances.
+ */
+CLOCK_MODE Clock_getMode() {
+    return mode;
+}
+
+/**
+ * @brief Sets the scale of CLOCK_MODE_SCALED, the virtual time passing during a wall clock second.
+ */
+void Clock_setScale(double s) {
+    scale = s < 0 ? 0 : s;
+}
+
+/**
+ * @brief Sets the step in µs of the fixed step modes.
+ */
+void Clock_setStep(Uint64 s) {
+    step = s;
+    paceNext = 0;
+}
+
+/**
+ * @brief Advances the clock, call it once at the start of every frame.
+ * @return the virtual time the frame lasts in µs.
+ */
+Uint64 Clock_tick() {
+    //the wall clock is always measured, so a change of mode doesn't return the time spent in the previous one
+    Uint64 wall = getDeltaUs();
+    Uint64 delta;
+    double scaled;
+
+    if (wall > CLOCK_MAX_DELTA)
+        wall = CLOCK_MAX_DELTA;
+
+    switch (mode) {
+        case CLOCK_MODE_REALTIME:
+            delta = wall;
+            break;
+        case CLOCK_MODE_SCALED:
+            //the fractions are carried over, so small scales still move the clock
+            scaled = wall * scale + scaledRemainder;
+            delta = (Uint64) scaled;
+            scaledRemainder = scaled - delta;
+            break;
+        case CLOCK_MODE_FIXED_STEP:
+            Clock_pace();
+            delta = step;
+            break;
+        default:
+            delta = step;
+            break;
+    }
+
+    SDL_AtomicLock(&nowLock);
+    now += delta;
+    SDL_AtomicUnlock(&nowLock);
+    return delta;
+}
+
+/**
+ * @brief Returns the virtual time since the start in µs, can be called from any thread.
+ */
+Uint64 Clock_now() {
+    Uint64 t;
+    SDL_AtomicLock(&nowLock);
+    t = now;
+    SDL_AtomicUnlock(&nowLock);
+    return t;
+}
+
+/**
+ * @brief Tells if the current frame should be rendered, call it once per frame.
+ *
+ * Always true, except in CLOCK_MODE_FAST, where a frame is rendered every CLOCK_RENDER_INTERVAL of wall clock time.
+ */
+int Clock_shouldRender() {
+    Uint64 wall;
+
+    if (mode != CLOCK_MODE_FAST)
+        return 1;
+
+    wall = getTimeUs();
+    if (lastRender != 0 && wall - lastRender < CLOCK_RENDER_INTERVAL)
+        return 0;
+
+    lastRender = wall;
+    return 1;
+}
+
+
+//private methods
+
+
+void Clock_pace() {
+    Uint64 wall = getTimeUs();
+
+    //the first frame, or we have fallen behind by more than a frame, don't try to catch up
+    if (paceNext == 0 || wall > paceNext + step)
+        paceNext = wall;
+
+    if (wall < paceNext)
+        SDL_Delay((Uint32) ((paceNext - wall) / 1000));
+
+    paceNext += step;
+}
@@ -15,9 +15,14 @@
 * along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <stdio.h>
+#include <string.h>
 #include <SDL_events.h>
 #include "../HEAD/input.h"
-#include "../../Utility/HEAD/bag.h"
+#include "../../Utility/HEAD/array.h"
+#include "../../Utility/HEAD/hashmap.h"
+#include "../../Utility/HEAD/ring.h"
+#include "../HEAD/timer.h"
 
 
 /**
@@ -28,10 +33,121 @@ typedef struct Subscriber {
     void *state;
 } Subscriber;
 
+DEFINE_ARRAY(Subscriber, SubscriberArray)
+
+/**
+ * @brief Internal representation of a bound key.
+ */
+typedef struct KeyRoute {
+    SDL_Keycode key;
+    keyConsumer consFunc;
+    int action;
+    void *state;
+} KeyRoute;
+
+DEFINE_ARRAY(KeyRoute, KeyRouteArray)
+
+/**@brief Identifies an input stream, followed by the version of the format.*/
+#define INPUT_STREAM_MAGIC "BSIN"
+#define INPUT_STREAM_VERSION (2)
+/**@brief The records of an input stream, each starts with its tag.*/
+#define INPUT_REC_FRAME (0) //the delta of the frame in µs
+#define INPUT_REC_EVENT (1) //the type and the offset of the event, for key events the keycode and the repeat flag
+/**@brief The size of the buffer the stream is read and written through.*/
+#define INPUT_STREAM_BUFFER (64 * 1024)
+/**@brief The number of events the input thread can queue up for the game thread.*/
+#define INPUT_QUEUE_SIZE (1024)
+/**@brief How often the input thread pumps the events, in ms.*/
+#define INPUT_THREAD_INTERVAL (1)
+
+/**
+ * @brief Internal, an event queued by the input thread, along with the wall clock time in µs it was taken at.
+ */
+typedef struct InputEvent {
+    SDL_Event event;
+    Uint64 time;
+} InputEvent;
+
+/**
+ * @brief Internal, where the events come from and go to.
+ */
+typedef enum INPUT_STREAM_MODE {
+    INPUT_LIVE,
+    INPUT_RECORDING,
+    INPUT_PLAYBACK
+} INPUT_STREAM_MODE;
+
 /**
  * @brief Internal list holding the subscribed functions.
  */
-static Bag *subscribers = NULL;
+static SubscriberArray subscribers;
+/**
+ * @brief Internal list of the bound keys, and the map from the keycodes to their indices in it.
+ */
+static KeyRouteArray routes;
+static HashMap *routeIndex = NULL;
+/**
+ * @brief Internal, the stream being recorded or played back.
+ */
+static INPUT_STREAM_MODE streamMode = INPUT_LIVE;
+static FILE *stream = NULL;
+/**
+ * @brief Internal, set once the live events of the current Input_process() have been dropped during playback.
+ */
+static int liveDropped = 0;
+/**
+ * @brief Internal, the input thread and the queue it passes the events through, NULL if it is not running.
+ */
+static SDL_Thread *inputThread = NULL;
+static SDL_atomic_t threadRunning;
+static SPSCRing queue;
+/**
+ * @brief Internal, the wall clock time the previous and the current frame began at, and the delta of the current one.
+ */
+static Uint64 frameStart = 0;
+static Uint64 frameEnd = 0;
+static Uint64 frameDelta = 0;
+/**
+ * @brief Internal, the offset and the wall clock time of the event being delivered, see Input_eventOffset().
+ */
+static Uint64 eventOffset = 0;
+static Uint64 eventTime = 0;
+
+/**
+ * @brief Private, delivers a key event to the keyConsumer it is bound to.
+ * @return the return value of the keyConsumer, 0 if the key is not bound.
+ */
+int Input_route(SDL_Event *e);
+/**
+ * @brief Private, returns the next event, from SDL or from the played back stream, 0 if there are none left this frame.
+ */
+int Input_poll(SDL_Event *e);
+/**
+ * @brief Private, returns the next live event, from SDL or from the input thread, 0 if there are none left.
+ */
+int Input_pollLive(SDL_Event *e);
+/**
+ * @brief Private, the input thread, pumps the events of SDL into the queue.
+ */
+int Input_thread(void *null);
+/**
+ * @brief Private, writes an event into the recorded stream.
+ */
+void Input_writeEvent(SDL_Event *e);
+/**
+ * @brief Private, reads the next event of the current frame from the played back stream.
+ * @return 0 if the frame has no more events.
+ */
+int Input_readEvent(SDL_Event *e);
+/**
+ * @brief Private, writes an unsigned number into the stream, 7 bits a byte, the lowest first.
+ */
+void Input_writeNumber(Uint64 n);
+/**
+ * @brief Private, reads a number written by Input_writeNumber().
+ * @return 0 if the stream has ended.
+ */
+int Input_readNumber(Uint64 *n);
 
 /**
  * @brief Initializes the module.
@@ -41,7 +157,9 @@ static Bag *subscribers = NULL;
  */
 void Input_init()
 {
-    subscribers = Bag_new(&free);
+    SubscriberArray_initTagged(MT_TAG_INPUT, NULL, &subscribers);
+    KeyRouteArray_initTagged(MT_TAG_INPUT, NULL, &routes);
+    routeIndex = HashMap_newTagged(MT_TAG_INPUT, NULL);
 }
 
 /**
@@ -49,15 +167,22 @@ void Input_init()
  */
 void Input_deinit()
 {
-    Bag_free(subscribers, 1);
+    Input_stopThread();
+    Input_stopStream();
+    SubscriberArray_free(&subscribers);
+    KeyRouteArray_free(&routes);
+    HashMap_free(routeIndex);
+    routeIndex = NULL;
 }
 
 /**
- * @brief Resets the list of subscribed functions.
+ * @brief Resets the list of subscribed functions and the key bindings.
  */
 void Input_clear()
 {
-    Bag_slowClear(subscribers, 1);
+    SubscriberArray_clear(&subscribers);
+    KeyRouteArray_clear(&routes);
+    HashMap_clear(routeIndex);
 }
 
 /**
@@ -70,12 +195,49 @@ void Input_clear()
  */
 void Input_subscribe(inputConsumer cons, void *state)
 {
-    Subscriber *sub = (Subscriber *) malloc(sizeof(Subscriber));
-    sub->consFuc = cons;
-    sub->state = state;
-    Bag_push(sub, subscribers);
+    Subscriber sub = {cons, state};
+    SubscriberArray_push(sub, &subscribers);
+}
+
+
+/**
+ * @brief Binds a key to a function, its key events are delivered straight to it.
+ * @param key The key to be bound, a key bound already is bound again, SDLK_UNKNOWN can't be bound.
+ * @param cons Function pointer to the keyConsumer function.
+ * @param action Passed to the function with each call, tells it what the key does.
+ * @param state Optional state pointer to be passed to the function with each call.
+ */
+void Input_bindKey(SDL_Keycode key, keyConsumer cons, int action, void *state)
+{
+    KeyRoute route = {key, cons, action, state};
+    int index;
+
+    //the keycode is the key of the map, which can't be NULL
+    if (key == SDLK_UNKNOWN)
+        return;
+
+    if (HashMap_get((void *) (intptr_t) key, &index, routeIndex))
+        routes.data[index] = route;
+    else
+        HashMap_insert((void *) (intptr_t) key, KeyRouteArray_push(route, &routes), routeIndex);
 }
 
+/**
+ * @brief Removes the binding of a key, its events go down the inputConsumer list again.
+ */
+void Input_unbindKey(SDL_Keycode key)
+{
+    int index;
+
+    if (key == SDLK_UNKNOWN || !HashMap_get((void *) (intptr_t) key, &index, routeIndex))
+        return;
+
+    HashMap_erase((void *) (intptr_t) key, routeIndex);
+    KeyRouteArray_unorderedRemove(index, &routes);
+    //the last route has been moved into the hole
+    if (index < routes.count)
+        HashMap_insert((void *) (intptr_t) routes.data[index].key, index, routeIndex);
+}
 
 /**
  * @brief Process accumulated SDL_Events by pushing them down the inputConsumer queue.
@@ -83,16 +245,333 @@ void Input_subscribe(inputConsumer cons, void *state)
 void Input_process()
 {
     //Cache some values locally for iteration.
-    int elemCount = subscribers->elemCount;
-    Subscriber **subs = (Subscriber **) subscribers->vector;
+    int elemCount = subscribers.count;
+    Subscriber *subs = subscribers.data;
     int i;
     SDL_Event e;
 
     //If an inputConsumer returns non-zero, the SDL_Event will be considered consumed and will not
     //be passed to successive inputConsumers in the list.
-    while (SDL_PollEvent(&e))
+    liveDropped = 0;
+    while (Input_poll(&e)) {
+        //bound keys go straight to their owner first
+        if ((e.type == SDL_KEYDOWN || e.type == SDL_KEYUP) && Input_route(&e) == 1)
+            continue;
+
         for (i = 0; i < elemCount; i++)
-            if ((subs[i]->consFuc(&e, subs[i]->state)) == 1)
+            if ((subs[i].consFuc(&e, subs[i].state)) == 1)
                 break;
+    }
+
+}
+
+/**
+ * @brief Starts recording the input into a file, the previous stream is closed.
+ * @param path The file to be written, it is truncated.
+ * @param seed The seed of rand(), stored for the playback.
+ * @return 0 on success, non-zero if the file can't be opened.
+ */
+int Input_startRecording(const char *path, Uint32 seed)
+{
+    Input_stopStream();
+    if ((stream = fopen(path, "wb")) == NULL) {
+        printf("FUNC: Input_startRecording. Error opening file: %s.\n", path);
+        return -1;
+    }
+
+    setvbuf(stream, NULL, _IOFBF, INPUT_STREAM_BUFFER);
+    fwrite(INPUT_STREAM_MAGIC, 1, 4, stream);
+    Input_writeNumber(INPUT_STREAM_VERSION);
+    Input_writeNumber(seed);
+    streamMode = INPUT_RECORDING;
+    return 0;
+}
+
+/**
+ * @brief Starts playing back a recorded file, the previous stream is closed.
+ * @param path The recorded file.
+ * @param seed Set to the seed of rand() the recording was made with.
+ * @return 0 on success, non-zero if the file can't be opened or is not a recording.
+ */
+int Input_startPlayback(const char *path, Uint32 *seed)
+{
+    char magic[4];
+    Uint64 version, s;
+
+    Input_stopStream();
+    if ((stream = fopen(path, "rb")) == NULL) {
+        printf("FUNC: Input_startPlayback. Error opening file: %s.\n", path);
+        return -1;
+    }
+
+    setvbuf(stream, NULL, _IOFBF, INPUT_STREAM_BUFFER);
+    if (fread(magic, 1, 4, stream) != 4 || memcmp(magic, INPUT_STREAM_MAGIC, 4) != 0 ||
+        !Input_readNumber(&version) || version != INPUT_STREAM_VERSION || !Input_readNumber(&s)) {
+        printf("FUNC: Input_startPlayback. Not an input recording: %s.\n", path);
+        fclose(stream);
+        stream = NULL;
+        return -1;
+    }
+
+    *seed = (Uint32) s;
+    streamMode = INPUT_PLAYBACK;
+    return 0;
+}
+
+/**
+ * @brief Closes the recorded or played back stream, the input comes from SDL again.
+ */
+void Input_stopStream()
+{
+    if (stream != NULL)
+        fclose(stream);
+    stream = NULL;
+    streamMode = INPUT_LIVE;
+}
+
+/**
+ * @brief Tells if the input is being played back.
+ */
+int Input_isPlaying()
+{
+    return streamMode == INPUT_PLAYBACK;
+}
+
+/**
+ * @brief Marks the start of a frame in the stream, call it once per frame before Input_process().
+ * @param delta The delta of the frame in µs.
+ * @return the delta to be used, the recorded one during playback.
+ */
+Uint64 Input_beginFrame(Uint64 delta)
+{
+    SDL_Event quit;
+    Uint64 now = getTimeUs();
+
+    //the events taken this frame have happened since the previous frame began
+    frameStart = frameEnd == 0 ? now : frameEnd;
+    frameEnd = now;
+
+    if (streamMode == INPUT_RECORDING) {
+        putc(INPUT_REC_FRAME, stream);
+        Input_writeNumber(delta);
+    } else if (streamMode == INPUT_PLAYBACK) {
+        //events left over from the previous frame are skipped, the frame marker is the next record
+        while (Input_readEvent(&quit))
+            ;
+
+        if (getc(stream) != INPUT_REC_FRAME || !Input_readNumber(&delta)) {
+            //the recording has run out, the game ends as it would have when it was recorded
+            Input_stopStream();
+            SDL_zero(quit);
+            quit.type = SDL_QUIT;
+            SDL_PushEvent(&quit);
+            delta = 0;
+        }
+    }
+
+    frameDelta = delta;
+    return delta;
+}
+
+/**
+ * @brief Returns when the event being delivered has happened, in µs from the start of the delta of the frame.
+ *
+ * Only the events queued by the input thread and the ones played back know their time, the rest are taken as if they
+ * had happened at the start of the frame, 0 is returned for them.
+ */
+Uint64 Input_eventOffset()
+{
+    return eventOffset;
+}
+
+/**
+ * @brief Returns the wall clock time in µs the event being delivered was taken at, see getTimeUs().
+ *
+ * The input thread stamps the events when it takes them from SDL, otherwise they are stamped by Input_process().
+ */
+Uint64 Input_eventTime()
+{
+    return eventTime;
+}
+
+/**
+ * @brief Starts the input thread, from then on it pumps the events of SDL and Input_process() takes them from it.
+ * @return 0 on success, non-zero if the thread can't be created.
+ */
+int Input_startThread()
+{
+    if (inputThread != NULL)
+        return 0;
+
+    SPSCRing_init(sizeof(InputEvent), INPUT_QUEUE_SIZE, &queue);
+    SDL_AtomicSet(&threadRunning, 1);
+    if ((inputThread = SDL_CreateThread(&Input_thread, "input", NULL)) == NULL) {
+        printf("FUNC: Input_startThread. Error creating thread. SDL_ERROR: %s.\n", SDL_GetError());
+        SPSCRing_free(&queue);
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Stops the input thread, the events it has queued are handed back to SDL.
+ */
+void Input_stopThread()
+{
+    InputEvent ie;
+
+    if (inputThread == NULL)
+        return;
+
+    SDL_AtomicSet(&threadRunning, 0);
+    SDL_WaitThread(inputThread, NULL);
+    inputThread = NULL;
+
+    while (SPSCRing_pop(&ie, &queue) == 0)
+        SDL_PushEvent(&ie.event);
+    SPSCRing_free(&queue);
+}
+
+
+//private methods
+
+
+int Input_route(SDL_Event *e)
+{
+    KeyRoute *route;
+    int index;
+
+    if (!HashMap_get((void *) (intptr_t) e->key.keysym.sym, &index, routeIndex))
+        return 0;
+
+    route = &routes.data[index];
+    return route->consFunc(e, route->action, route->state);
+}
+
+int Input_poll(SDL_Event *e)
+{
+    if (streamMode != INPUT_PLAYBACK) {
+        if (!Input_pollLive(e))
+            return 0;
+        if (streamMode == INPUT_RECORDING)
+            Input_writeEvent(e);
+        return 1;
+    }
+
+    //the live events are dropped, only closing the window is let through
+    while (!liveDropped && Input_pollLive(e))
+        if (e->type == SDL_QUIT)
+            return 1;
+
+    liveDropped = 1;
+    return Input_readEvent(e);
+}
+
+int Input_pollLive(SDL_Event *e)
+{
+    InputEvent ie;
+
+    if (inputThread == NULL) {
+        eventOffset = 0;
+        eventTime = getTimeUs();
+        return SDL_PollEvent(e);
+    }
+
+    if (SPSCRing_pop(&ie, &queue) != 0)
+        return 0;
+
+    //the wall clock time of the event is mapped onto the delta of the frame, late comers go to its end
+    *e = ie.event;
+    eventTime = ie.time;
+    if (ie.time <= frameStart || frameEnd <= frameStart)
+        eventOffset = 0;
+    else if (ie.time >= frameEnd)
+        eventOffset = frameDelta;
+    else
+        eventOffset = (Uint64) ((double) (ie.time - frameStart) / (frameEnd - frameStart) * frameDelta);
+    return 1;
+}
+
+int Input_thread(void *null)
+{
+    InputEvent ie;
+
+    while (SDL_AtomicGet(&threadRunning)) {
+        SDL_PumpEvents();
+        while (SDL_PeepEvents(&ie.event, 1, SDL_GETEVENT, SDL_FIRSTEVENT, SDL_LASTEVENT) == 1) {
+            ie.time = getTimeUs();
+            //a full queue is waited out, a dropped key up would leave the key held down
+            while (SPSCRing_push(&ie, &queue) != 0 && SDL_AtomicGet(&threadRunning))
+                SDL_Delay(INPUT_THREAD_INTERVAL);
+        }
+
+        SDL_Delay(INPUT_THREAD_INTERVAL);
+    }
+
+    return 0;
+}
+
+void Input_writeEvent(SDL_Event *e)
+{
+    putc(INPUT_REC_EVENT, stream);
+    Input_writeNumber(e->type);
+    Input_writeNumber(eventOffset);
+    //the consumers only look at the keys of key events, and at the type of the rest
+    if (e->type == SDL_KEYDOWN || e->type == SDL_KEYUP) {
+        Input_writeNumber((Uint32) e->key.keysym.sym);
+        putc(e->key.repeat, stream);
+    }
+}
+
+int Input_readEvent(SDL_Event *e)
+{
+    Uint64 type, offset, sym;
+    int c;
+
+    //the events of the frame end at the next frame marker
+    if ((c = getc(stream)) != INPUT_REC_EVENT) {
+        if (c != EOF)
+            ungetc(c, stream);
+        return 0;
+    }
+
+    if (!Input_readNumber(&type) || !Input_readNumber(&offset))
+        return 0;
+
+    eventOffset = offset;
+    eventTime = getTimeUs();
+    SDL_zerop(e);
+    e->type = (Uint32) type;
+    if (e->type == SDL_KEYDOWN || e->type == SDL_KEYUP) {
+        if (!Input_readNumber(&sym) || (c = getc(stream)) == EOF)
+            return 0;
+        e->key.keysym.sym = (SDL_Keycode) (Uint32) sym;
+        e->key.repeat = (Uint8) c;
+        e->key.state = e->type == SDL_KEYDOWN ? SDL_PRESSED : SDL_RELEASED;
+    }
+    return 1;
+}
+
+void Input_writeNumber(Uint64 n)
+{
+    while (n >= 0x80) {
+        putc((int) (n & 0x7F) | 0x80, stream);
+        n >>= 7;
+    }
+    putc((int) n, stream);
+}
+
+int Input_readNumber(Uint64 *n)
+{
+    int c, shift = 0;
 
+    *n = 0;
+    do {
+        if ((c = getc(stream)) == EOF || shift > 63)
+            return 0;
+        *n |= (Uint64) (c & 0x7F) << shift;
+        shift += 7;
+    } while (c & 0x80);
+    return 1;
 }
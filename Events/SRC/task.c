@@ -0,0 +1,100 @@
+/*
+* Copyright (C) 2015 Bendegúz Nagy
+* 
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+* 
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+* 
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "../HEAD/task.h"
+
+/**
+ * @brief Private, the timed event callback resuming a Task.
+ */
+int Task_resume(Uint32 delta, Timer *timer, void *data);
+/**
+ * @brief Private, registers the timed event continuing the Task after its function has returned a status.
+ */
+void Task_schedule(int status, Task *task);
+
+/**
+ * @brief Initializes a Task which is not running.
+ */
+void Task_init(Task *task) {
+    task->func = NULL;
+    task->state = NULL;
+    task->line = 0;
+    task->elapsed = task->wait = 0;
+    task->event = HANDLE_NULL;
+}
+
+/**
+ * @brief Starts a Task, the function is run up to its first yield or wait right away.
+ * @param func The function of the Task.
+ * @param state The state pointer passed to the function.
+ * @param task The Task, it is stopped first if it is running.
+ */
+void Task_start(Task_func func, void *state, Task *task) {
+    Task_stop(task);
+    task->func = func;
+    task->state = state;
+    task->elapsed = task->wait = 0;
+    Task_schedule(func(task, 0, state), task);
+}
+
+/**
+ * @brief Stops a Task, its function is not resumed any more.
+ */
+void Task_stop(Task *task) {
+    TM_cancel(task->event);
+    task->event = HANDLE_NULL;
+    task->line = 0;
+}
+
+/**
+ * @brief Tells if a Task has yet to finish.
+ */
+int Task_isRunning(Task *task) {
+    return TM_isAlive(task->event);
+}
+
+
+//private methods
+
+
+int Task_resume(Uint32 delta, Timer *timer, void *data) {
+    Task *task = (Task*)data;
+    Uint32 wait = task->wait;
+    int status;
+
+    //a wait lasts exactly as long as it was asked to, a yield lasts a frame
+    task->elapsed += wait != 0 ? wait : delta;
+    status = task->func(task, delta, task->state);
+
+    //the event is kept if the Task wants to be resumed the same way, a delayed one is re-armed by Timer_man
+    if ((status == TASK_YIELDED && wait == 0) || (status == TASK_WAITING && task->wait == wait && wait != 0))
+        return 0;
+
+    Task_schedule(status, task);
+    return 1;
+}
+
+void Task_schedule(int status, Task *task) {
+    if (status == TASK_WAITING && task->wait != 0) {
+        task->event = TM_newDelayed(task->wait, &Task_resume, task);
+    } else if (status != TASK_DONE) {
+        task->wait = 0;
+        task->event = TM_new(&Task_resume, task);
+    } else {
+        task->event = HANDLE_NULL;
+    }
+}
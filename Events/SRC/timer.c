@@ -17,20 +17,17 @@
 
 #include <stdlib.h>
 #include "../HEAD/timer.h"
-
-/**
- * @brief Internal representation of time-keeping objects.
- */
-struct Timer {
-    Uint32 ticksRunning;
-    int isStarted;
-};
-
+#include "../../Utility/HEAD/memtrack.h"
 
 /**
  * @brief Used by getDelta(), holds the time the function was last called.
  */
 static Uint32 lastDelta = 0;
+/**
+ * @brief Used by getDeltaUs(), holds the time the function was last called and whether it has been called at all.
+ */
+static Uint64 lastTimeUs = 0;
+static int clockStarted = 0;
 
 
 /**
@@ -43,12 +40,43 @@ Uint32 getDelta() {
     return relTime;
 }
 
+/**
+ * @brief Returns the time on a monotonic clock in µs, only the difference of two readings is meaningful.
+ */
+Uint64 getTimeUs() {
+    static Uint64 freq = 0;
+    Uint64 counter = SDL_GetPerformanceCounter();
+
+    if (freq == 0)
+        freq = SDL_GetPerformanceFrequency();
+    //converted in two parts, so the counter is never multiplied by a million
+    return counter / freq * 1000000 + counter % freq * 1000000 / freq;
+}
+
+/**
+ * @brief Returns the µs between now and the last time this function was called, 0 the first time.
+ */
+Uint64 getDeltaUs() {
+    Uint64 now = getTimeUs();
+    Uint64 relTime;
+
+    //the counter starts at an arbitrary value, the first call only starts the clock
+    if (!clockStarted) {
+        clockStarted = 1;
+        lastTimeUs = now;
+    }
+
+    relTime = now - lastTimeUs;
+    lastTimeUs = now;
+    return relTime;
+}
+
 /**
  * @brief Creates a paused Timer object with zero ticks.
  * @return Returns the newly allocated Timer object.
  */
 Timer *Timer_new() {
-    Timer *ptr = (Timer *) malloc(sizeof(Timer));
+    Timer *ptr = (Timer *) MT_malloc(sizeof(Timer), MT_TAG_TIMER);
     ptr->ticksRunning = 0;
     ptr->isStarted = 0;
     return ptr;
@@ -59,7 +87,7 @@ Timer *Timer_new() {
  * @param ptr The Timer object to be destroyed.
  */
 void Timer_free(Timer *ptr) {
-    free(ptr);
+    MT_free(ptr);
 }
 
 /**
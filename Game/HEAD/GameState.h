@@ -27,7 +27,8 @@
  */
 
 int Game_start();
-void Game_func(uint32_t delta);
+void Game_func(double delta);
 int Game_end();
+void Game_deinit();
 
 #endif //DUMMY_GAMELOGIC_H
@@ -30,7 +30,7 @@
 #include <stdint.h>
 
 int LevelSel_start();
-void LevelSel_func(uint32_t delta);
+void LevelSel_func(double delta);
 int LevelSel_end();
 
 
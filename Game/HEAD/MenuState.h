@@ -28,7 +28,7 @@
  */
 
 int Menu_start(void);
-void Menu_func(uint32_t delta);
+void Menu_func(double delta);
 int Menu_end(void);
 
 
@@ -78,8 +78,8 @@ extern char *currMapPath;
 
 /**@brief State init function signature.*/
 typedef int (*StateStart)(void);
-/**@brief State flow function signature.*/
-typedef void (*StateFunc)(uint32_t delta);
+/**@brief State flow function signature, delta is the time passed since the last call in seconds.*/
+typedef void (*StateFunc)(double delta);
 /**@brief State deinit function signature.*/
 typedef int (*StateEnd)(void);
 
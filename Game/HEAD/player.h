@@ -20,6 +20,9 @@
 
 
 #include "../../Collision/HEAD/physics.h"
+#include "../../Utility/HEAD/hashmap.h"
+#include "../../Events/HEAD/task.h"
+#include "../../Events/HEAD/input.h"
 #include "../HEAD/player.h"
 
 
@@ -34,6 +37,10 @@
  *
  * Each state function follows the same pattern. Check the STATE_INIT flag, do some logic, check if transition should
  * occur to another state.
+ *
+ * Bullets, the respawn task and anything else which can outlive a player refer to it by its generational Handle,
+ * Player_get() returns NULL once the player is freed. The player keeps the Handle of its attackbox the same way. Its
+ * own tasks live inside it and are stopped by Player_free(), so they are given the pointer.
  */
 
 
@@ -59,12 +66,27 @@ typedef enum PLAYER_CONTKEYFLAGS {
     MOV_RIGHT = 8
 } PLAYER_CONTKEYFLAGS;
 
+/**
+ * @brief The actions the keys of a player are bound to, in the order the keys are stored.
+ */
+typedef enum PLAYER_ACTION {
+    ACTION_UP,
+    ACTION_DOWN,
+    ACTION_LEFT,
+    ACTION_RIGHT,
+    ACTION_ATTACK,
+    ACTION_JUMP,
+    ACTION_DASH,
+    ACTION_SHOOT,
+    PLAYER_ACTION_TOTAL
+} PLAYER_ACTION;
+
 
 /**
  * @brief Player state flags, stored in an int by OR-ing together.
  */
 typedef enum PLAYER_FLAGS {
-    //set by the player collision callback
+    //set from the bottom contact of the player's physics object
     ON_THE_GROUND = 1,
     //means the player is gonna be dead
     DAMAGED = 2,
@@ -106,19 +128,19 @@ typedef void (*stateFunc)(Player *p);
  * @brief Each player has one of these, hold data for the attacking state.
  */
 typedef struct AttackData {
-    int isLive; //is the player currently attacking?
     int usedUp; //has e used it up to destory a block?
     Vector2D relPos; //realitve poisiton of the attackbox in regards to the player
-    Object *box; //the attackbox object thing
-    int attCD; //cooldown of the attack
+    Handle box; //the attackbox object thing, the player is attacking while it exists
+    Task task; //removes the attackbox once the attack is over
+    double attCD; //cooldown of the attack in ms
 } AttackData;
 
 /**
  * @brief Each player has one of these, hold data for the dashing state.
  */
 typedef struct DashData {
-    int dashCD; //dash cooldown
-    int isLive; //is this player in dash?
+    double dashCD; //dash cooldown in ms
+    Task task; //keeps the player moving, the player is dashing while it runs
     Vector2D dir; //direction of the dash
 } DashData;
 
@@ -126,21 +148,24 @@ typedef struct DashData {
  * @brief Each player has one of these, hold data for the shooting state.
  */
 typedef struct ShootData {
-    int shootCD; //cooldown for shooting
+    double shootCD; //cooldown for shooting in ms
     int shootCount; //nmber of bullets left
     Bag *bag; //bag containing the bullets of this player
+    HashMap *index; //the index of each bullet in the bag
 } ShootData;
 
 /**
  * @brief Holds every data defining a player.
  */
 typedef struct Player {
+    //the generational handle of this player
+    Handle handle;
     //the world this player belongs to
     World *world;
     //the physics object that represents the player
     Object *phObj;
-    //up, down, left, right, attack, jump, dash, shoot
-    SDL_Keycode keys[8];
+    //up, down, left, right, attack, jump, dash, shoot, indexed by PLAYER_ACTION
+    SDL_Keycode keys[PLAYER_ACTION_TOTAL];
 
     //current state
     stateFunc state;
@@ -168,14 +193,18 @@ typedef struct Player {
 
 void Player_initModule();
 void Player_deinitModule();
+void Player_registerHandlers(World *world);
 
 Player *Player_new(int x, int y, World *world);
 void Player_free(Player *player);
+Player *Player_get(Handle handle);
 void Player_reset(Player *p);
 
-int Player_feedInput(SDL_Event *e, Player *p);
-void Player_update(Player *p, Uint32 delta);
-void Player_postRender(Uint32 delta);
+int Player_keyInput(SDL_Event *e, int action, Player *p);
+void Player_bindKeys(keyConsumer cons, Player *p);
+void Player_update(Player *p, double delta);
+void Player_react(Player *p, World *world);
+void Player_postRender(double delta);
 
 void Player_setState(PLAYER_STATE state, Player *p);
 int Player_compState(PLAYER_STATE state, Player *p);
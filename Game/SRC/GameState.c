@@ -17,25 +17,42 @@
 
 #include "../HEAD/GameState.h"
 #include "../../Collision/HEAD/physics.h"
+#include "../../Collision/HEAD/physics_async.h"
 #include "../HEAD/player.h"
 #include "../HEAD/main.h"
 #include "../../Events/HEAD/input.h"
 #include "../../Events/HEAD/timer.h"
 #include "../../Events/HEAD/Timer_man.h"
+#include "../../Events/HEAD/task.h"
+#include "../../Events/HEAD/clock.h"
 #include "../../Graphics/HEAD/graphics_man.h"
 #include "../../Graphics/HEAD/textsprite.h"
+#include "../../Graphics/HEAD/latency.h"
 
 #define PLAYER_COUNT 2
 #define GRAVITY -1700
 #define RESPAWN_TIME 1000
 #define WIN_SCORE 5
-
+#define CHUNK_SIZE 200
+#define CHUNK_RADIUS 1
+//the size of the blocks the match arena grows by, a match on the bundled maps fits in one
+#define ARENA_BLOCK_SIZE (64 * 1024)
+
+//set this to non-zero to step the world on its own thread
+#ifndef GAME_ASYNC_PHYSICS
+#define GAME_ASYNC_PHYSICS 0
+#endif
+//the milliseconds a key waits for room in the full command queue of the physics thread
+#define ASYNC_RETRY_DELAY 1
+
+/**@brief Everything created for a match is allocated from here, Game_end() releases it at once.*/
+Arena *gameArena = NULL;
 /**@brief The physics world singleton used for the game.*/
 World *world;
 /**@brief Array holding player objects, currently hardcoded for 2.*/
 Player *players[PLAYER_COUNT];
-/**@brief Bag holding 2D vectors of possible spawn positions, read from map file.*/
-Bag *spawnPos = NULL;
+/**@brief Array holding 2D vectors of possible spawn positions, read from map file.*/
+Vector2DArray spawnPos;
 
 /**@brief Flag for "is game paused?" question.*/
 int Game_paused;
@@ -46,12 +63,66 @@ SDL_Rect youreWinnerRect = {490, 200, 221, 237};
 /**@brief Text object to be displayed at the end of a game.*/
 TextSprite *winText = NULL;
 
+/**@brief If non-zero, the world is stepped on its own thread.*/
+int Game_asyncPhysics = GAME_ASYNC_PHYSICS;
+/**@brief The world running on the physics thread, NULL if the game runs on the main thread.*/
+PH_AsyncWorld *asyncWorld = NULL;
+/**@brief Scores published by the physics thread for rendering.*/
+SDL_atomic_t asyncScores[PLAYER_COUNT];
+/**@brief Set by the physics thread when someone has won.*/
+SDL_atomic_t asyncWinner;
+/**@brief Fraction of a µs the physics thread could not yet pass to the timers.*/
+double asyncTimeAcc;
+/**@brief The latency tracing seq of the last key the physics thread has taken, owned by the physics thread.*/
+int asyncKeySeq;
+/**@brief Waits out the respawn time of a dead player, then respawns it.*/
+Task respawnTask;
+
 /**@brief Respawns a player.*/
-int Game_respawn(uint32_t delta, Timer *timer, Player *p);
+int Game_respawnTask(Task *task, Uint32 delta, void *handle);
 
 /**@brief Input consumer used at the end of a game to process the ESC key.*/
 int Game_escapeInputProc(SDL_Event *e, void *null);
 
+/**@brief Steps the game logic and the world, returns non-zero if someone has won.*/
+int Game_simulate(double delta);
+/**@brief Renders the world and the scores.*/
+void Game_render(int score0, int score1);
+/**@brief Displays the end game screen and waits for the ESC key.*/
+void Game_showWinner();
+
+/**@brief The tick function of the physics thread.*/
+void Game_asyncTick(World *w, double delta, void *null);
+/**@brief A key event of a player forwarded to the physics thread or held back until its step, fits PH_CMD_DATA_SIZE.*/
+typedef struct Game_keyCommand {
+    Player *player;
+    int action;
+    SDL_KeyboardEvent key;
+    double time; //when it has happened, in seconds from the start of the frame's delta
+    int seq; //its latency tracing seq, -1 if it isn't traced
+} Game_keyCommand;
+
+DEFINE_ARRAY(Game_keyCommand, Game_keyCommandArray)
+
+/**@brief Key events of the players held back until the world gets to their time, in the order they have happened.*/
+Game_keyCommandArray pendingKeys;
+/**@brief The first key event in pendingKeys which has not been applied yet.*/
+int pendingNext;
+
+/**@brief Key consumer forwarding the key events of the players to the physics thread.*/
+int Game_forwardKey(SDL_Event *e, int action, Player *p);
+/**@brief Feeds a forwarded key event to its player on the physics thread.*/
+void Game_asyncInput(World *w, Game_keyCommand *cmd, void *null);
+
+/**@brief Key consumer holding the key events of the players back until the world gets to their time.*/
+int Game_queueKey(SDL_Event *e, int action, Player *p);
+/**@brief Feeds the held back key events which have happened by time to their players, returns the players as bits.*/
+int Game_applyKeys(double time);
+/**@brief The step function of the world, applies the key events which have happened by the end of the step.*/
+void Game_stepKeys(World *w, double time, void *null);
+/**@brief Tags a key press of a player for the latency tracing, returns its seq, -1 if it isn't traced.*/
+int Game_traceKey(SDL_Event *e);
+
 int Game_start()
 {
     int i;
@@ -67,11 +138,16 @@ int Game_start()
     TS_setPos(SCREEN_WIDTH / 2 - TS_getWidth(winText) / 2, 200, winText);
 
 
-    //load map
-    spawnPos = Bag_new((freeData) &VEC2D_free);
-    world = PH_createWorld();
+    //load map, the match lives in the arena
+    if (gameArena == NULL)
+        gameArena = Arena_new(ARENA_BLOCK_SIZE);
+    Vector2DArray_initIn(gameArena, &spawnPos);
+    world = PH_createWorldIn(gameArena);
     PH_setGravity(0, GRAVITY, world);
     PH_setStepTime(1.0 / 120.0, world);
+    //the maps fit on the screen, anything outside is put into the border chunks, dormant chunks are frozen
+    PH_setChunks(CHUNK_SIZE, SCREEN_WIDTH / CHUNK_SIZE + 1, SCREEN_HEIGHT / CHUNK_SIZE + 1, CHUNK_RADIUS, 0, world);
+    PH_setTileColor(WALL, 100, 100, 100, 0xFF, world);
 
     FILE *file = fopen(currMapPath, "rt");
     if (!file)
@@ -93,10 +169,8 @@ int Game_start()
         if (!doneReadingMapFile)
             switch (v[0]) {
                 case PLAYER: {
-                    Vector2D *vec = (Vector2D *) malloc(sizeof(Vector2D));
-                    vec->x = v[1];
-                    vec->y = v[2];
-                    Bag_push(vec, spawnPos);
+                    Vector2D vec = {v[1], v[2]};
+                    Vector2DArray_push(vec, &spawnPos);
                     break;
                 }
                 case BLOCK: {
@@ -106,9 +180,11 @@ int Game_start()
                     break;
                 }
                 case WALL: {
-                    Object *o = PH_createBox(v[1], v[2], v[3], v[4], 1, HYBRID, world);
-                    PH_setUData(NULL, WALL, o);
-                    PH_setColor(100, 100, 100, 0xFF, o);
+                    //walls never move, they are stored as tiles
+                    if(PH_addTile(v[1], v[2], v[3], v[4], WALL, world) < 0) {
+                        fclose(file);
+                        return -1;
+                    }
                     break;
                 }
             }
@@ -117,16 +193,18 @@ int Game_start()
 
     fclose(file);
     //means we have less than two spawnpoints
-    if(spawnPos->elemCount < 2)
+    if(spawnPos.count < 2)
         return -1;
 
     //spawn players and set them up
-    Vector2D *s1 = spawnPos->vector[rand() % spawnPos->elemCount];
+    Vector2D *s1 = &spawnPos.data[rand() % spawnPos.count];
     Vector2D *s2 = s1;
     while (s2 == s1)
-        s2 = spawnPos->vector[rand() % spawnPos->elemCount];
+        s2 = &spawnPos.data[rand() % spawnPos.count];
 
     Player_initModule();
+    Player_registerHandlers(world);
+    Task_init(&respawnTask);
     players[0] = Player_new(s1->x, s1->y, world);
     players[1] = Player_new(s2->x, s2->y, world);
 
@@ -137,117 +215,305 @@ int Game_start()
     Player_setControl(SDLK_KP_5, SDLK_KP_2, SDLK_KP_1, SDLK_KP_3, SDLK_DOWN, SDLK_UP, SDLK_RIGHT, SDLK_LEFT,
                       players[1]);
 
+    Game_keyCommandArray_initIn(gameArena, &pendingKeys);
+    pendingNext = 0;
+
+    //from now on the world and the players belong to the physics thread, input is handed over through its queue
+    if (Game_asyncPhysics) {
+        for (i = 0; i < PLAYER_COUNT; i++)
+            SDL_AtomicSet(&asyncScores[i], 0);
+        SDL_AtomicSet(&asyncWinner, 0);
+        asyncTimeAcc = 0;
+        asyncKeySeq = -1;
+
+        if ((asyncWorld = PH_startAsync(world, &Game_asyncTick, &Clock_now, NULL)) == NULL)
+            return -1;
+        TM_setOwner(PH_asyncThreadID(asyncWorld));
+        for (i = 0; i < PLAYER_COUNT; i++)
+            Player_bindKeys((keyConsumer) &Game_forwardKey, players[i]);
+        return 0;
+    }
+
+    //each key goes to the player it belongs to, at the step it has happened in
+    PH_setStepFunc(&Game_stepKeys, NULL, world);
     for (i = 0; i < PLAYER_COUNT; i++)
-        Input_subscribe((inputConsumer) &Player_feedInput, players[i]);
+        Player_bindKeys((keyConsumer) &Game_queueKey, players[i]);
+
+    return 0;
+}
+
+
+void Game_func(double delta)
+{
+    int won;
+
+    //the physics thread does the simulation, we only have to draw what it has published
+    if (asyncWorld != NULL) {
+        if (SDL_AtomicGet(&asyncWinner)) {
+            //take the world and the timers back, the game is over anyway
+            PH_stopAsync(asyncWorld);
+            asyncWorld = NULL;
+            TM_setOwner(SDL_ThreadID());
+            Game_paused = 1;
+            Game_showWinner();
+            return;
+        }
+
+        Game_render(SDL_AtomicGet(&asyncScores[0]), SDL_AtomicGet(&asyncScores[1]));
+        return;
+    }
+
+    if (Game_paused) {
+        //the keys still count, like they did before the pause
+        Game_applyKeys(delta);
+        return;
+    }
+
+    won = Game_simulate(delta);
+    //the keys taken so far have been simulated
+    LT_simulated();
+
+    //if there was a winner, 'pause' the game and wait for an esc key
+    if (won) {
+        Game_showWinner();
+        return;
+    }
+
+    Game_render(players[0]->score, players[1]->score);
+
+    //post render stuff
+    Player_postRender(delta);
+}
+
+int Game_end()
+{
+    //the world has to be ours before it can be destroyed
+    if (asyncWorld != NULL) {
+        PH_stopAsync(asyncWorld);
+        asyncWorld = NULL;
+        TM_setOwner(SDL_ThreadID());
+    }
+
+    SDL_DestroyTexture(youreWinner);
+    TS_free(winText);
+    Task_stop(&respawnTask);
+    Player_deinitModule();
 
+    //the world, its objects, the players and the spawn points go at once, the memory is kept for the next match
+    if (gameArena != NULL)
+        Arena_reset(gameArena);
     return 0;
 }
 
+//frees the memory kept between matches, called once before exiting
+void Game_deinit()
+{
+    Arena_free(gameArena);
+    gameArena = NULL;
+}
+
+
+//private methods
+
+
+int Game_respawnTask(Task *task, Uint32 delta, void *handle)
+{
+    Player *p = Player_get(HANDLE_FROM_PTR(handle));
+    Vector2D *vec;
+
+    TASK_BEGIN(task);
+    TASK_WAIT(task, RESPAWN_TIME);
+
+    //the player has been freed in the meantime
+    if (p == NULL)
+        TASK_EXIT(task);
+
+    //the time is up, choose a random respawn for the player and resume the game
+    vec = &spawnPos.data[rand() % spawnPos.count];
+    PH_setPosition(*vec, p->phObj);
+    Player_reset(p);
+    Game_paused = 0;
+    TASK_END(task);
+}
 
-void Game_func(uint32_t delta)
+int Game_simulate(double delta)
 {
     int i;
 
     if (Game_paused)
-        return;
+        return 0;
 
     //check if someone has reached the winning score
-    int winner = 0;
     for (i = 0; i < PLAYER_COUNT; i++)
         if (players[i]->score >= WIN_SCORE) {
-            winner = 1;
-            break;
+            Game_paused = 1;
+            return 1;
         }
 
-    //if there was a winner, 'pause' the game and wait for an esc key
-    if (winner) {
-        Game_paused = 1;
-        SDL_RenderCopy(gRenderer, youreWinner, NULL, &youreWinnerRect);
-        TS_render(winText);
-        SDL_RenderPresent(gRenderer);
-        Input_subscribe((inputConsumer) &Game_escapeInputProc, NULL);
-
-        return;
-    } else
-        //if there was no winner, then check for dead players, if there are, then pause the game
-        //then when the timer is up, resume it
-        for (i = 0; i < PLAYER_COUNT; i++)
-            if (Player_compState(DEAD, players[i])) {
-                Game_paused = 1;
-                TM_new((Timer_callBack) &Game_respawn, players[i]);
-                break;
-            }
+    //if there was no winner, then check for dead players, if there are, then pause the game
+    //then when the timer is up, resume it
+    for (i = 0; i < PLAYER_COUNT; i++)
+        if (Player_compState(DEAD, players[i])) {
+            Game_paused = 1;
+            Task_start(&Game_respawnTask, HANDLE_TO_PTR(players[i]->handle), &respawnTask);
+            break;
+        }
 
-    //update the world
-    PH_stepWorld(delta / 1000.0, world);
+    //update the world, the keys which have happened after its last step are applied before the players are updated
+    PH_stepWorld(delta, world);
+    Game_applyKeys(delta);
 
     //this is after
     for (i = 0; i < PLAYER_COUNT; i++)
         Player_update(players[i], delta);
 
+    return 0;
+}
+
+void Game_render(int score0, int score1)
+{
+    int i;
+
+    //running faster than real time, only a frame now and then is shown
+    if (!Clock_shouldRender())
+        return;
 
     SDL_SetRenderDrawColor(gRenderer, 0xFF, 0xFF, 0xFF, 0xFF);
     SDL_RenderClear(gRenderer);
     //begin render
 
     //render physics engine
-    PH_renderObjects(world);
+    if (asyncWorld != NULL)
+        PH_renderAsync(asyncWorld);
+    else
+        PH_renderObjects(world);
 
 
     //render scores
     SDL_SetRenderDrawColor(gRenderer, 0x43, 0xA1, 0x6F, 0xFF);
-    for (i = 0; i < players[0]->score; i++) {
+    for (i = 0; i < score0; i++) {
         SDL_Rect r = {50 + i * 30, 15, 15, 15};
         SDL_RenderFillRect(gRenderer, &r);
     }
 
     SDL_SetRenderDrawColor(gRenderer, 0xFF, 0x66, 0x00, 0xFF);
-    for (i = 0; i < players[1]->score; i++) {
+    for (i = 0; i < score1; i++) {
         SDL_Rect r = {1150 - i * 30, 665, 15, 15};
         SDL_RenderFillRect(gRenderer, &r);
     }
 
     //end render
-    SDL_RenderPresent(gRenderer);
+    LT_present();
+}
 
-    //post render stuff
-    Player_postRender(delta);
+void Game_showWinner()
+{
+    SDL_RenderCopy(gRenderer, youreWinner, NULL, &youreWinnerRect);
+    TS_render(winText);
+    LT_present();
+    Input_subscribe((inputConsumer) &Game_escapeInputProc, NULL);
 }
 
-int Game_end()
+void Game_asyncTick(World *w, double delta, void *null)
 {
-    Bag_free(spawnPos, 1);
     int i;
+    Uint64 us;
+
+    //the timers take whole µs, carry the rest over to the next tick
+    asyncTimeAcc += delta * 1000000.0;
+    us = (Uint64) asyncTimeAcc;
+    asyncTimeAcc -= us;
+
+    TM_processUs(us);
+    if (Game_simulate(delta))
+        SDL_AtomicSet(&asyncWinner, 1);
+    //only the keys whose commands have been run, the ones still in the queue are taken by the next tick
+    LT_simulatedUpTo(asyncKeySeq);
+    Player_postRender(delta);
+
     for (i = 0; i < PLAYER_COUNT; i++)
-        Player_free(players[i]);
+        SDL_AtomicSet(&asyncScores[i], players[i]->score);
+}
 
-    PH_destroyWorld(world);
+int Game_forwardKey(SDL_Event *e, int action, Player *p)
+{
+    //the player belongs to the physics thread, it is only passed along
+    Game_keyCommand cmd = {p, action, e->key, 0, Game_traceKey(e)};
 
-    SDL_DestroyTexture(youreWinner);
-    TS_free(winText);
-    Player_deinitModule();
+    //a full queue is waited out, the physics thread empties it every tick, a dropped key up would leave the key held
+    while (PH_asyncCall((PH_commandFunc) &Game_asyncInput, &cmd, sizeof(cmd), NULL, asyncWorld) != 0)
+        SDL_Delay(ASYNC_RETRY_DELAY);
+
+    //don't consume the event, the main thread may need it too
     return 0;
 }
 
+void Game_asyncInput(World *w, Game_keyCommand *cmd, void *null)
+{
+    SDL_Event e;
 
-//private methods
+    e.key = cmd->key;
+    Player_keyInput(&e, cmd->action, cmd->player);
+    if (cmd->seq != -1)
+        asyncKeySeq = cmd->seq;
+}
+
+int Game_queueKey(SDL_Event *e, int action, Player *p)
+{
+    Game_keyCommand cmd = {p, action, e->key, Input_eventOffset() / 1000000.0, -1};
+
+    //while paused nothing is simulated or rendered, the keys would only measure the pause
+    if (!Game_paused)
+        cmd.seq = Game_traceKey(e);
+
+    //keys from the start of the frame, and every key when nothing is held back, don't have to wait
+    if (cmd.time == 0 && pendingNext == pendingKeys.count)
+        return Player_keyInput(e, action, p);
 
+    Game_keyCommandArray_push(cmd, &pendingKeys);
+    //it can't be told yet if the player will take it
+    return 0;
+}
 
-int Game_respawn(uint32_t delta, Timer *timer, Player *p)
+int Game_applyKeys(double time)
 {
-    Timer_updateDelta(delta, timer);
-
-    //if the timer is up then choose a random respawn for the player
-    //and resume the game
-    if (Timer_getTicks(timer) >= RESPAWN_TIME) {
-        Vector2D *vec = spawnPos->vector[rand() % spawnPos->elemCount];
-        PH_setPosition(*vec, p->phObj);
-        Player_reset(p);
-        Game_paused = 0;
-        return 1;
+    Game_keyCommand *cmd;
+    SDL_Event e;
+    int i, applied = 0;
+
+    while (pendingNext < pendingKeys.count && pendingKeys.data[pendingNext].time <= time) {
+        cmd = &pendingKeys.data[pendingNext++];
+        e.key = cmd->key;
+        Player_keyInput(&e, cmd->action, cmd->player);
+        for (i = 0; i < PLAYER_COUNT; i++)
+            if (players[i] == cmd->player)
+                applied |= 1 << i;
     }
 
-    return 0;
+    //everything has been applied, the storage is reused
+    if (pendingNext == pendingKeys.count) {
+        Game_keyCommandArray_clear(&pendingKeys);
+        pendingNext = 0;
+    }
+    return applied;
+}
+
+void Game_stepKeys(World *w, double time, void *null)
+{
+    int i, changed = Game_applyKeys(time);
+
+    //the players react to their keys before the step, their cooldowns only count at the end of the frame
+    for (i = 0; i < PLAYER_COUNT; i++)
+        if (changed & (1 << i))
+            Player_react(players[i], w);
+}
+
+int Game_traceKey(SDL_Event *e)
+{
+    //only presses are followed, releases and repeats don't change much on the screen
+    if (e->type == SDL_KEYDOWN && !e->key.repeat)
+        return LT_input(Input_eventTime(), e->key.keysym.sym);
+    return -1;
 }
 
 int Game_escapeInputProc(SDL_Event *e, void *null)
@@ -89,7 +89,7 @@ int LevelSel_start() {
     return 0;
 }
 
-void LevelSel_func(uint32_t delta) {
+void LevelSel_func(double delta) {
     int i; //generic iterator
 
 
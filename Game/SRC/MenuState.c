@@ -98,7 +98,7 @@ int Menu_start(void) {
     return 0;
 }
 
-void Menu_func(uint32_t delta) {
+void Menu_func(double delta) {
     int i; //generic iterator
 
 
@@ -16,18 +16,25 @@
 */
 
 #include <stdio.h>
+#include <string.h>
 #include <SDL_image.h>
 #include <time.h>
 #include "../HEAD/main.h"
 #include "../HEAD/MenuState.h"
 #include "../../Graphics/HEAD/graphics_man.h"
 #include "../../Events/HEAD/timer.h"
+#include "../../Events/HEAD/clock.h"
 #include "../../Events/HEAD/Timer_man.h"
 #include "../../Events/HEAD/input.h"
 #include "../HEAD/LevelSelState.h"
 #include "../HEAD/GameState.h"
 #include "../../Graphics/HEAD/textsprite.h"
+#include "../../Graphics/HEAD/latency.h"
+#include "../../Utility/HEAD/frame.h"
+#include "../../Utility/HEAD/memtrack.h"
 
+//the size of the blocks the frame memory grows by
+#define FRAME_BLOCK_SIZE (64 * 1024)
 
 
 /**
@@ -36,8 +43,22 @@
 typedef struct MAIN_DATA {
     /**@brief The exit flag.*/
     int keepRunning;
-    /**@brief The the passed since the last main cycle run.*/
-    uint32_t delta;
+    /**@brief The time passed since the last main cycle run in µs.*/
+    Uint64 deltaUs;
+    /**@brief The seed of rand(), used if seeded is set, taken from the replay when there is one.*/
+    Uint32 seed;
+    int seeded;
+    /**@brief The file the input is recorded into or played back from, NULL if none.*/
+    char *recordPath;
+    char *replayPath;
+    /**@brief The frames played back and the wall clock time the playback started at, for the benchmark.*/
+    Uint64 replayFrames;
+    Uint64 replayStart;
+    /**@brief If set, the events are pumped on the input thread.*/
+    int inputThread;
+    /**@brief If set, the input latency is traced, logged into latencyPath if it is not NULL.*/
+    int latency;
+    char *latencyPath;
 } MAIN_DATA;
 
 /**
@@ -58,10 +79,14 @@ char *currMapPath = "res/maps/map1.dat";
 
 int Main_init();
 void Main_deinit();
+/**@brief Sets the clock, the seed and the input stream up from the command line arguments.*/
+void Main_parseArgs(int argc, char *args[]);
 /**@brief Input consumer for Window X clicks.*/
 int Main_quitInputCB(SDL_Event *e, void *null);
 
 int main(  int argc, char* args[] ) {
+    Main_parseArgs(argc, args);
+
     //set things up, if stuff happens, then Main_init will return non-zero
     //in that case we exit the app
     if(Main_init()) {
@@ -72,18 +97,29 @@ int main(  int argc, char* args[] ) {
 
     //this is our main loop
     while(mData.keepRunning) {
-        //get delta
-        mData.delta = getDelta();
+        //get delta from the virtual clock, in µs so high refresh rates don't quantize the frames to whole ms
+        //a replay brings its own deltas
+        mData.deltaUs = Input_beginFrame(Clock_tick());
+        if(Input_isPlaying())
+            mData.replayFrames++;
 
         //update the timers
-        TM_process(mData.delta);
+        TM_processUs(mData.deltaUs);
         //consume the accumulated input events
         Input_process();
         //call the current state function
-        stFunc[currState](mData.delta);
+        stFunc[currState](mData.deltaUs / 1000000.0);
+        //everything allocated for the frame is released at once
+        Frame_reset();
+        MT_endFrame();
     }
 
 
+    //a replay doubles as a benchmark
+    if(mData.replayPath != NULL)
+        printf("Replay: %lu frames in %.3f s.\n", (unsigned long)mData.replayFrames,
+               (getTimeUs() - mData.replayStart) / 1000000.0);
+
     //exit normally
     Main_deinit();
     return 0;
@@ -110,14 +146,12 @@ void SwapGlobalState(GlobalState stateTo) {
 }
 
 int Main_init() {
-    //init random numbers
-    srand(time(NULL));
     //the state we will start from
     GlobalState initState = MAIN_MENU;
 
     //initializes MAINDATA
     mData.keepRunning = 1;
-    mData.delta = 0;
+    mData.deltaUs = 0;
 
 
     //setup state table
@@ -138,8 +172,27 @@ int Main_init() {
 
     //init modules
     TS_init("res/oblivious.ttf");
+    LT_init();
+    Frame_init(FRAME_BLOCK_SIZE);
     TM_init();
     Input_init();
+    if(mData.inputThread && Input_startThread())
+        return -1;
+
+    //init random numbers, a replay has to get the same ones as the recording
+    if(!mData.seeded)
+        mData.seed = (Uint32)time(NULL);
+    if(mData.replayPath != NULL) {
+        if(Input_startPlayback(mData.replayPath, &mData.seed))
+            return -1;
+        mData.replayStart = getTimeUs();
+    } else if(mData.recordPath != NULL && Input_startRecording(mData.recordPath, mData.seed)) {
+        return -1;
+    }
+    srand(mData.seed);
+
+    if(mData.latency && LT_start(mData.latencyPath))
+        return -1;
 
     Input_subscribe((inputConsumer)&Main_quitInputCB, NULL);
     //init the beginning state
@@ -162,10 +215,54 @@ void Main_setExitFlag() {
     mData.keepRunning = 0;
 }
 
+//--scale <factor> scales the wall clock, --fixed [ms] and --fast [ms] advance the clock by fixed steps,
+//at real speed and as fast as possible respectively
+//--seed <n> seeds rand(), --record <file> records the input, --replay <file> plays it back
+//--input-thread pumps the events on their own thread, so they are applied at the time they have happened
+//--latency [file] shows the input latency on the screen, and logs every key press into the file
+void Main_parseArgs(int argc, char *args[]) {
+    int i;
+    CLOCK_MODE mode;
+
+    for(i = 1; i < argc; i++) {
+        if(strcmp(args[i], "--scale") == 0 && i + 1 < argc) {
+            Clock_setMode(CLOCK_MODE_SCALED);
+            Clock_setScale(atof(args[++i]));
+        } else if(strcmp(args[i], "--fixed") == 0 || strcmp(args[i], "--fast") == 0) {
+            mode = strcmp(args[i], "--fast") == 0 ? CLOCK_MODE_FAST : CLOCK_MODE_FIXED_STEP;
+            Clock_setMode(mode);
+            //the step is optional
+            if(i + 1 < argc && atof(args[i + 1]) > 0)
+                Clock_setStep((Uint64)(atof(args[++i]) * 1000.0));
+        } else if(strcmp(args[i], "--seed") == 0 && i + 1 < argc) {
+            mData.seed = (Uint32)strtoul(args[++i], NULL, 10);
+            mData.seeded = 1;
+        } else if(strcmp(args[i], "--record") == 0 && i + 1 < argc) {
+            mData.recordPath = args[++i];
+        } else if(strcmp(args[i], "--replay") == 0 && i + 1 < argc) {
+            mData.replayPath = args[++i];
+        } else if(strcmp(args[i], "--input-thread") == 0) {
+            mData.inputThread = 1;
+        } else if(strcmp(args[i], "--latency") == 0) {
+            mData.latency = 1;
+            //the log is optional
+            if(i + 1 < argc && strncmp(args[i + 1], "--", 2) != 0)
+                mData.latencyPath = args[++i];
+        } else {
+            printf("Unknown argument: %s.\n", args[i]);
+        }
+    }
+}
+
 void Main_deinit() {
     stEnd[currState]();
+    Game_deinit();
     Input_deinit();
     TM_deinit();
+    LT_deinit();
     TS_deinit();
+    Frame_deinit();
     GM_deinit();
+    //everything should be freed by now
+    MT_reportLeaks();
 }
@@ -41,52 +41,92 @@
 
 
 
-/**
- * @brief Helper bag fro querying stuff, do not assume it's contents will remain the same in between function calls.
- */
-Bag *queryBag = NULL;
 /**
  * @brief Only push and only objects onto this. Holds PH_Objects which could not be deleted during a callback.
  */
 Bag *destroyBag = NULL;
+/**
+ * @brief Resolves the handles of the living players, see Player_get().
+ */
+HandleTable playerHandles;
 
 /**
  * @brief This has to be called before the player module is put to use. Calling this multiple times without calling
  * Player_deinitModule() in between will cause a memory leak.
  */
 void Player_initModule() {
-    queryBag = Bag_new(NULL);
     destroyBag = Bag_new(NULL);
+    HandleTable_init(&playerHandles);
 }
 /**
  * @brief Deinitializes the player module.
  */
 void Player_deinitModule() {
-    Bag_free(queryBag, 0);
     Bag_free(destroyBag, 0);
-    queryBag = destroyBag = NULL;
+    destroyBag = NULL;
+    HandleTable_free(&playerHandles);
 }
 
 /**
- * @brief Defines a timer callback function for pulling the player out of the attacking state and destroying it's attackbox.
+ * @brief Defines a task which destroys the attackbox once the attack is over, pulling the player out of the attacking state.
+ */
+int Player_attackTask(Task *task, Uint32 delta, void *player);
+/**
+ * @brief Pair handler for attackboxes hitting players.
+ */
+void Player_attackHitPlayer(PH_Manifold *contacts, int count, void *null);
+/**
+ * @brief Pair handler for attackboxes hitting blocks.
+ */
+void Player_attackHitBlock(PH_Manifold *contacts, int count, void *null);
+/**
+ * @brief Pair handler for two attackboxes clashing.
+ */
+void Player_attackHitAttack(PH_Manifold *contacts, int count, void *null);
+/**
+ * @brief Defines a task moving the player for the length of the dash, then pulling it out of the dashing state.
+ */
+int Player_dashTask(Task *task, Uint32 delta, void *player);
+/**
+ * @brief Private, returns the attackbox of a player, NULL if it is not attacking.
+ */
+Object *Player_getAttackBox(Player *p);
+/**
+ * @brief Pair handler for bullets hitting players.
  */
-int Player_attackRemoveTimer(Uint32 delta, Timer *timer, Player *p);
+void Player_bulletHitPlayer(PH_Manifold *contacts, int count, void *null);
 /**
- * @brief PH_callback for the attackbox collisions.
+ * @brief Pair handler for bullets hitting blocks.
  */
-int Player_attackBoxColl(PH_Manifold *m, Object *callObj, Object *collObj, Player *p);
+void Player_bulletHitBlock(PH_Manifold *contacts, int count, void *null);
 /**
- * @brief PH_callback for player collisions.
+ * @brief Pair handler for bullets hitting walls.
  */
-int Player_collCallBack(PH_Manifold *m, Object *A, Object *B, Player *player);
+void Player_bulletHitWall(PH_Manifold *contacts, int count, void *null);
 /**
- * @brief Defines a timer callback function for pulling the player out of the dashing state.
+ * @brief Pair handler for bullets being deflected by attackboxes.
  */
-int Player_dashTimer(Uint32 delta, Timer *timer, Player *p);
+void Player_bulletHitAttack(PH_Manifold *contacts, int count, void *null);
 /**
- * @brief PH_callback for bullets.
+ * @brief Removes a bullet from its owner and queues it for destruction.
  */
-int Player_bulletCB(PH_Manifold *m, Object *A, Object *B, Player *p);
+void Player_spendBullet(Object *bullet);
+/**
+ * @brief Returns the owner of a bullet, NULL if the bullet has been spent or its owner has been freed.
+ */
+Player *Player_getOwner(Object *bullet);
+/**
+ * @brief Adds a bullet to a player's bullets.
+ */
+void Player_addBullet(Object *bullet, Player *p);
+/**
+ * @brief Removes a bullet from a player's bullets in constant time, does nothing if it is not one of them.
+ */
+void Player_removeBullet(Object *bullet, Player *p);
+/**
+ * @brief Queues a block for destruction, returns zero if it has already been destroyed.
+ */
+int Player_destroyBlock(Object *block);
 
 //logic state functions
 void Player_still(Player *p);
@@ -128,19 +168,58 @@ const stateFunc movStates[3] = {
         &Player_groundMov
 };
 
+/**
+ * @brief The key flag of each PLAYER_ACTION, the movement actions are held in contKeyDown, the rest in keyDown.
+ */
+const uint32_t actionFlags[PLAYER_ACTION_TOTAL] = {
+    MOV_UP,
+    MOV_DOWN,
+    MOV_LEFT,
+    MOV_RIGHT,
+    ATT_KEY,
+    JUMP_KEY,
+    DASH_KEY,
+    SHOOT_KEY
+};
+
+/**
+ * @brief Registers the pair handlers of the bullets and the attackboxes in a world, call this before the players are
+ * created.
+ *
+ * The handlers are called in the order of registration, hits on players come first, so a bullet touching a player
+ * and a wall during the same step will always score.
+ */
+void Player_registerHandlers(World *world) {
+    PH_setPairHandler(BULLET, PLAYER, &Player_bulletHitPlayer, NULL, world);
+    PH_setPairHandler(ATTACKBOX, PLAYER, &Player_attackHitPlayer, NULL, world);
+    PH_setPairHandler(BULLET, ATTACKBOX, &Player_bulletHitAttack, NULL, world);
+    PH_setPairHandler(ATTACKBOX, ATTACKBOX, &Player_attackHitAttack, NULL, world);
+    PH_setPairHandler(BULLET, BLOCK, &Player_bulletHitBlock, NULL, world);
+    PH_setPairHandler(ATTACKBOX, BLOCK, &Player_attackHitBlock, NULL, world);
+    PH_setPairHandler(BULLET, WALL, &Player_bulletHitWall, NULL, world);
+}
+
 /**
  * @brief Create a new player with no color or controlling keys.
  */
 Player *Player_new(int x, int y, World *world) {
-    Player *player = (Player*)malloc(sizeof(Player));
+    //a player lives as long as its world, so it shares its memory
+    Arena *arena = PH_getArena(world);
+    Player *player = (Player*)Arena_alloc(sizeof(Player), arena);
 
+    player->handle = HandleTable_add(player, &playerHandles);
     player->world = world;
+    player->attData.box = HANDLE_NULL;
+    Task_init(&player->attData.task);
+    Task_init(&player->dashData.task);
     player->phObj = PH_createBox(x, y, 32, 32, 1, DYNAMIC, world);
     PH_setUData(player, PLAYER, player->phObj);
-    PH_setCallback((PH_callback)&Player_collCallBack, player, player->phObj);
+    //the world is only simulated around the players
+    PH_setActivator(1, player->phObj);
 
     PH_setVelCap(XCAP, YCAP, player->phObj);
-    player->shData.bag = Bag_new(NULL);
+    player->shData.bag = Bag_newIn(NULL, arena);
+    player->shData.index = HashMap_newIn(arena);
     Player_reset(player);
     player->score = 0;
 
@@ -156,17 +235,19 @@ void Player_reset(Player *p) {
     Player_setMovState(FLY, p);
     p->keyDown = p->contKeyDown =
     p->flags = p->attData.attCD =
-    p->dashData.dashCD = p->shData.shootCD =
-    p->dashData.isLive = 0;
+    p->dashData.dashCD = p->shData.shootCD = 0;
     p->shData.shootCount = SHOOT_COUNT;
-    p->attData.box = NULL;
-    p->attData.isLive = 0;
     p->attData.usedUp = 0;
+    //whatever is left of the previous life won't touch the new one
+    Task_stop(&p->dashData.task);
+    Task_stop(&p->attData.task);
+    PH_destroyObject(Player_getAttackBox(p));
 
     int i;
     for(i=0; i<p->shData.bag->elemCount; i++)
         PH_destroyObject(p->shData.bag->vector[i]);
     Bag_fastClear(p->shData.bag);
+    HashMap_clear(p->shData.index);
 }
 
 /**
@@ -211,83 +292,71 @@ void Player_setControl(SDL_Keycode up, SDL_Keycode down, SDL_Keycode left, SDL_K
 }
 
 /**
- * @brief Deallocates a player.
+ * @brief Deallocates a player, a player in an arena world is released with the arena instead.
  */
 void Player_free(Player *player) {
+    //the tasks live inside the player, they can't outlive it
+    HandleTable_remove(player->handle, &playerHandles);
+    Task_stop(&player->dashData.task);
+    Task_stop(&player->attData.task);
     PH_destroyObject(player->phObj);
-    PH_destroyObject(player->attData.box);
+    PH_destroyObject(Player_getAttackBox(player));
     Bag_free(player->shData.bag, 0);
-    free(player);
+    HashMap_free(player->shData.index);
+    Arena_release(player, PH_getArena(player->world));
 }
 
 /**
- * @brief Input consumer for a player.
+ * @brief Returns the player a handle refers to, NULL if the player has been freed since.
  */
-int Player_feedInput(SDL_Event *e, Player *p) {
-    //if the event is not of type 'key', this will contain garbage
-    SDL_Keycode k = e->key.keysym.sym;
-    int repeat = e->key.repeat;
+Player *Player_get(Handle handle) {
+    return (Player*)HandleTable_get(handle, &playerHandles);
+}
+
+Object *Player_getAttackBox(Player *p) {
+    return PH_getObject(p->attData.box, p->world);
+}
+
+/**
+ * @brief Key consumer for a player, the action is a PLAYER_ACTION.
+ */
+int Player_keyInput(SDL_Event *e, int action, Player *p) {
     //this should only be used for checking if change has occurred
     uint32_t prevContKeyDown = p->contKeyDown;
     //this should only be used for checking if change has occurred
     uint32_t kD = p->keyDown;
-
-    switch (e->type) {
-        case SDL_KEYDOWN: {
-            if (k == p->keys[0]) {
-                p->contKeyDown |= MOV_UP;
-            } else if (k == p->keys[1]) {
-                p->contKeyDown |= MOV_DOWN;
-            } else if (k == p->keys[2]) {
-                p->contKeyDown |= MOV_LEFT;
-            } else if (k == p->keys[3]) {
-                p->contKeyDown |= MOV_RIGHT;
-            } else if (k == p->keys[4] && !repeat) {
-                p->keyDown |= ATT_KEY;
-            } else if (k == p->keys[5] && !repeat) {
-                p->keyDown |= JUMP_KEY;
-            } else if (k == p->keys[6] && !repeat) {
-                p->keyDown |= DASH_KEY;
-            } else if (k == p->keys[7] && !repeat) {
-                p->keyDown |= SHOOT_KEY;
-            }
-        }
-            break;
-        case SDL_KEYUP: {
-
-            if (k == p->keys[0]) {
-                p->contKeyDown &= ~MOV_UP;
-            } else if (k == p->keys[1]) {
-                p->contKeyDown &= ~MOV_DOWN;
-            } else if (k == p->keys[2]) {
-                p->contKeyDown &= ~MOV_LEFT;
-            } else if (k == p->keys[3]) {
-                p->contKeyDown &= ~MOV_RIGHT;
-            }
-        }
+    uint32_t flag = actionFlags[action];
+
+    //movement keys count while they are held, the others only when they are pressed
+    if (action <= ACTION_RIGHT) {
+        if (e->type == SDL_KEYDOWN)
+            p->contKeyDown |= flag;
+        else if (e->type == SDL_KEYUP)
+            p->contKeyDown &= ~flag;
+    } else if (e->type == SDL_KEYDOWN && !e->key.repeat) {
+        p->keyDown |= flag;
     }
 
     //returns if there has been a change, eg. the event had been consumed
     return kD != p->keyDown || p->contKeyDown != prevContKeyDown;
 }
 
-int Player_collCallBack(PH_Manifold *m, Object *A, Object *B, Player *player) {
-    //if the player collided with a 'solid' object and was moving downward, then he is on the ground
-    if(B->type == STATIC || B->type == HYBRID) {
-        Vector2D vec = VEC2D_sub(&A->aabb.center, &A->lastPos);
-        if(vec.y < 0)
-            player->flags |= ON_THE_GROUND;
-
-    }
+/**
+ * @brief Binds the keys of a player in the input module, set them with Player_setControl() first.
+ * @param cons Gets the key events with their PLAYER_ACTION and the player, usually Player_keyInput().
+ */
+void Player_bindKeys(keyConsumer cons, Player *p) {
+    int i;
 
-    //player collides with everything
-    return 1;
+    //bound backwards, so if a key is set for more actions, the first one gets it, like it did in the input chain
+    for (i = PLAYER_ACTION_TOTAL - 1; i >= 0; i--)
+        Input_bindKey(p->keys[i], cons, i, p);
 }
 
 /**
  * @brief Call this function after rendering has been compelted.
  */
-void Player_postRender(Uint32 delta) {
+void Player_postRender(double delta) {
     //destroy the objects which should have been destroyed in a
     //PH_callback, but could not have been because ... it was in a PH_callback
     int i;
@@ -297,18 +366,23 @@ void Player_postRender(Uint32 delta) {
 }
 /**
  * @brief Updates a player, does like calling the state and movement function.
+ * @param delta The time passed since the last update in seconds.
  */
-void Player_update(Player *p, Uint32 delta) {
+void Player_update(Player *p, double delta) {
     //save previous states to later check if there has been a change
     stateFunc prevState = p->state;
     stateFunc prevMovState = p->movState;
 
-    //update player cooldowns
-    if((p->attData.attCD -= delta) < 0)
+    //if the player is standing on something and isn't moving upward, then he is on the ground
+    if(p->phObj->contacts.flags & PH_CONTACT(PH_BOTTOM) && p->phObj->velocity.y <= 0)
+        p->flags |= ON_THE_GROUND;
+
+    //update player cooldowns, they count in ms
+    if((p->attData.attCD -= delta * 1000.0) < 0)
         p->attData.attCD = 0;
-    if((p->dashData.dashCD -= delta) < 0)
+    if((p->dashData.dashCD -= delta * 1000.0) < 0)
         p->dashData.dashCD = 0;
-    if((p->shData.shootCD -= delta) < 0)
+    if((p->shData.shootCD -= delta * 1000.0) < 0)
         p->shData.shootCD = 0;
 
     //let the states do their magic
@@ -328,6 +402,19 @@ void Player_update(Player *p, Uint32 delta) {
     p->keyDown = 0;
 }
 
+/**
+ * @brief Runs the states of a player again in the middle of a frame, after its keys have changed.
+ * The forces the states have applied so far are cleared first, so they are not added twice.
+ */
+void Player_react(Player *p, World *world) {
+    PH_resetForce(p->phObj, world);
+    Player_update(p, 0);
+
+    //a moving dash keeps the forces cleared, its task only does it once a frame
+    if(Task_isRunning(&p->dashData.task) && p->dashData.task.elapsed != 0)
+        p->phObj->forceSum.x = p->phObj->forceSum.y = 0;
+}
+
 /**
  * @brief When the player is on the ground and is not moving.
  */
@@ -484,9 +571,11 @@ void Player_shoot(Player *p) {
         //means we have created a shootbox
         if(shootBox != NULL) {
             //we init stuff
-            Bag_push(shootBox, p->shData.bag);
-            PH_setUData(p, BULLET, shootBox);
-            PH_setCallback((PH_callback)&Player_bulletCB, p, shootBox);
+            //the owner's handle is stored in the user data, it is cleared once the bullet has hit something
+            Player_addBullet(shootBox, p);
+            PH_setUData(HANDLE_TO_PTR(p->handle), BULLET, shootBox);
+            //live bullets keep the chunks they fly through awake
+            PH_setActivator(1, shootBox);
             p->shData.shootCD = SHOOT_CD;
             p->shData.shootCount--;
             shootBox->color = p->phObj->color;
@@ -512,36 +601,107 @@ void Player_shoot(Player *p) {
         Player_setState(DEAD, p);
 }
 
-int Player_bulletCB(PH_Manifold *m, Object *A, Object *B, Player *p) {
-
-    //collision with an attackbox is an exception
-    //as it does not destroy the bullet
-    if(B->userData.type == ATTACKBOX) {
-        A->velocity.x *= -1;
-        A->velocity.y *= -1;
-        A->cbState = B->userData.data;
-        //if the shot already participated in a callback, we ignore further collisions
-    } else if(Bag_search(A, destroyBag) == -1) {
-
-        if (B->userData.type == PLAYER) {
-            Player *damP = (Player *) B->userData.data;
-            damP->flags |= DAMAGED;
-            Bag_push(A, destroyBag);
-            Bag_unorderedRemove(Bag_search(A, p->shData.bag), p->shData.bag);
-            p->score++;
-        } else if (B->userData.type == BLOCK) {
-            if (Bag_search(B, destroyBag) == -1)
-                Bag_push(B, destroyBag);
-            Bag_push(A, destroyBag);
-            Bag_unorderedRemove(Bag_search(A, p->shData.bag), p->shData.bag);
-        } else if (B->userData.type == WALL) {
-            if (Bag_search(A, destroyBag) == -1)
-                Bag_push(A, destroyBag);
-            Bag_unorderedRemove(Bag_search(A, p->shData.bag), p->shData.bag);
+void Player_bulletHitPlayer(PH_Manifold *contacts, int count, void *null) {
+    int i;
+    Player *owner;
+
+    for(i = 0; i < count; i++) {
+        //if the shot has already hit something, we ignore further collisions
+        if(contacts[i].A->userData.data == NULL)
+            continue;
+
+        //a bullet outliving its owner still hits, but scores for no one
+        ((Player*)contacts[i].B->userData.data)->flags |= DAMAGED;
+        if((owner = Player_getOwner(contacts[i].A)) != NULL)
+            owner->score++;
+        Player_spendBullet(contacts[i].A);
+    }
+}
+
+void Player_bulletHitBlock(PH_Manifold *contacts, int count, void *null) {
+    int i;
+
+    for(i = 0; i < count; i++) {
+        if(contacts[i].A->userData.data == NULL)
+            continue;
+
+        Player_destroyBlock(contacts[i].B);
+        Player_spendBullet(contacts[i].A);
+    }
+}
+
+void Player_bulletHitWall(PH_Manifold *contacts, int count, void *null) {
+    int i;
+
+    for(i = 0; i < count; i++)
+        if(contacts[i].A->userData.data != NULL)
+            Player_spendBullet(contacts[i].A);
+}
+
+void Player_bulletHitAttack(PH_Manifold *contacts, int count, void *null) {
+    int i;
+    Object *bullet;
+    Player *owner, *deflector;
+
+    //collision with an attackbox does not destroy the bullet, it gets sent back and changes sides
+    for(i = 0; i < count; i++) {
+        bullet = contacts[i].A;
+        owner = Player_getOwner(bullet);
+        deflector = (Player*)contacts[i].B->userData.data;
+
+        bullet->velocity.x *= -1;
+        bullet->velocity.y *= -1;
+
+        if(bullet->userData.data != NULL && owner != deflector) {
+            if(owner != NULL)
+                Player_removeBullet(bullet, owner);
+            Player_addBullet(bullet, deflector);
+            bullet->userData.data = HANDLE_TO_PTR(deflector->handle);
         }
     }
+}
 
-    return 0;
+void Player_spendBullet(Object *bullet) {
+    Player *owner = Player_getOwner(bullet);
+
+    if(owner != NULL)
+        Player_removeBullet(bullet, owner);
+    Bag_push(bullet, destroyBag);
+    //marks the bullet as spent, it can not hit anything else before it is destroyed
+    bullet->userData.data = NULL;
+}
+
+Player *Player_getOwner(Object *bullet) {
+    return Player_get(HANDLE_FROM_PTR(bullet->userData.data));
+}
+
+void Player_addBullet(Object *bullet, Player *p) {
+    HashMap_insert(bullet, Bag_push(bullet, p->shData.bag), p->shData.index);
+}
+
+void Player_removeBullet(Object *bullet, Player *p) {
+    int i;
+    Bag *bag = p->shData.bag;
+
+    //not one of the player's bullets, there is nothing to remove
+    if(!HashMap_get(bullet, &i, p->shData.index))
+        return;
+
+    HashMap_erase(bullet, p->shData.index);
+    Bag_unorderedRemove(i, bag);
+    //the last bullet has been moved into the hole
+    if(i != bag->elemCount)
+        HashMap_insert(bag->vector[i], i, p->shData.index);
+}
+
+int Player_destroyBlock(Object *block) {
+    if(block->userData.type != BLOCK)
+        return 0;
+
+    Bag_push(block, destroyBag);
+    //the block is no longer a target of the handlers, it won't be pushed twice
+    PH_setUData(NULL, NONE, block);
+    return 1;
 }
 
 /**
@@ -552,26 +712,24 @@ void Player_dash(Player *p) {
         uint32_t k = p->contKeyDown;
         p->dashData.dir.x = p->dashData.dir.y = 0;
 
-        if(k & MOV_LEFT) {
+        if(k & MOV_LEFT)
             p->dashData.dir.x -= DASH_SPEED;
-            p->dashData.isLive = 1;
-        } else if(k & MOV_RIGHT) {
+        else if(k & MOV_RIGHT)
             p->dashData.dir.x += DASH_SPEED;
-            p->dashData.isLive = 1;
-        }
 
-        if(p->dashData.isLive) {
+        //the dash lasts as long as its task
+        if(p->dashData.dir.x != 0 || p->dashData.dir.y != 0) {
             p->dashData.dashCD = DASH_CD;
             if(p->dashData.dir.x != 0)
                 p->phObj->velCapX = DASH_SPEED;
             if(p->dashData.dir.y != 0)
                 p->phObj->velCapY = DASH_SPEED;
-            TM_new((Timer_callBack)&Player_dashTimer, p);
+            Task_start(&Player_dashTask, p, &p->dashData.task);
         }
     }
 
     //transition only if the dash has been finished
-    if(p->dashData.isLive == 0) {
+    if(!Task_isRunning(&p->dashData.task)) {
         if(p->flags & ON_THE_GROUND) {
             Player_setState(STILL, p);
             if(p->contKeyDown & (MOV_LEFT | MOV_RIGHT))
@@ -585,34 +743,29 @@ void Player_dash(Player *p) {
 
     if(p->flags & DAMAGED) {
         Player_setState(DEAD, p);
-        p->dashData.isLive = 0;
+        Task_stop(&p->dashData.task);
         p->phObj->velCapX = XCAP;
         p->phObj->velCapY = YCAP;
         p->phObj->velocity.x  = p->phObj->velocity.y = 0;
     }
 }
 
-int Player_dashTimer(Uint32 delta, Timer *timer, Player *p) {
-    //the player has been destroyed
-    //the attackbox has been destroyed
-    if(p->dashData.isLive == 0)
-        return 1;
-
-    Timer_updateDelta(delta, timer);
+int Player_dashTask(Task *task, Uint32 delta, void *player) {
+    Player *p = (Player*)player;
 
-    Uint32 ticks = Timer_getTicks(timer);
-    if(ticks > DASH_DURR) {
-        p->dashData.isLive = 0;
-        p->phObj->velCapX = XCAP;
-        p->phObj->velCapY = YCAP;
-        p->phObj->velocity.x  = p->phObj->velocity.y = 0;
-        return 1;
-    } else {
+    TASK_BEGIN(task);
+    //the dash starts moving the player from the next frame on
+    TASK_YIELD(task);
+    while(task->elapsed <= DASH_DURR) {
         p->phObj->velocity = p->dashData.dir;
         p->phObj->forceSum.x = p->phObj->forceSum.y = 0;
-        return 0;
+        TASK_YIELD(task);
     }
 
+    p->phObj->velCapX = XCAP;
+    p->phObj->velCapY = YCAP;
+    p->phObj->velocity.x  = p->phObj->velocity.y = 0;
+    TASK_END(task);
 }
 
 
@@ -625,7 +778,8 @@ void Player_attack(Player *p) {
 
         //here we take care of spawning attack boxes
         //and do so only if there is none
-        if(p->attData.isLive == 0) {
+        if(Player_getAttackBox(p) == NULL) {
+            Object *box = NULL;
             uint32_t k = p->contKeyDown;
             int const sh = 10, lo = 39; // short and long dimensions
             float pW, pH, pad;
@@ -636,45 +790,44 @@ void Player_attack(Player *p) {
             //we set the pos to 0,0, the next operation will take care
             //of positioning
             if(k & MOV_UP) {
-                p->attData.box = PH_createBox(0, 0, sh, lo, 1, HYBRID, p->world);
+                box = PH_createBox(0, 0, sh, lo, 1, HYBRID, p->world);
                 p->attData.relPos.x = -(sh/2);
                 p->attData.relPos.y = (pH + pad);
             } else if (k & MOV_DOWN) {
-                p->attData.box = PH_createBox(0, 0, sh, lo, 1, HYBRID, p->world);
+                box = PH_createBox(0, 0, sh, lo, 1, HYBRID, p->world);
                 p->attData.relPos.x = -(sh/2);
                 p->attData.relPos.y = -(pH + pad + lo);
             } else if (k & MOV_LEFT) {
-                p->attData.box = PH_createBox(0, 0, lo, sh, 1, HYBRID, p->world);
+                box = PH_createBox(0, 0, lo, sh, 1, HYBRID, p->world);
                 p->attData.relPos.x = -(pW + pad + lo);
                 p->attData.relPos.y = -(sh/2);
             } else if (k & MOV_RIGHT) {
-                p->attData.box = PH_createBox(0, 0, lo, sh, 1, HYBRID, p->world);
+                box = PH_createBox(0, 0, lo, sh, 1, HYBRID, p->world);
                 p->attData.relPos.x = (pW + pad);
                 p->attData.relPos.y = -(sh/2);
             }
 
             //means we have created an attackbox
-            if(p->attData.box != NULL) {
-                //create a timer that will eventually destroy the box and
+            if(box != NULL) {
+                //start a task that will eventually destroy the box and
                 //allows us to transition into other states
-                TM_new((Timer_callBack) &Player_attackRemoveTimer, p);
-                //set the PH_callback
-                PH_setCallback((PH_callback) &Player_attackBoxColl, p, p->attData.box);
+                p->attData.box = PH_getHandle(box);
+                Task_start(&Player_attackTask, p, &p->attData.task);
                 p->attData.attCD = ATTACK_CD;
                 p->attData.usedUp = 0;
-                p->attData.isLive = 1;
-                PH_setUData(p, ATTACKBOX, p->attData.box);
-                p->attData.box->color = p->phObj->color;
+                PH_setUData(p, ATTACKBOX, box);
+                box->color = p->phObj->color;
             }
         }
     }
 
-    if(p->attData.isLive)
-        PH_setPosition(VEC2D_add(&p->attData.relPos, &p->phObj->aabb.center), p->attData.box);
+    Object *box = Player_getAttackBox(p);
+    if(box != NULL)
+        PH_setPosition(VEC2D_add(&p->attData.relPos, &p->phObj->aabb.center), box);
 
 
     //only transition if the attack has ended
-    if(p->attData.isLive == 0) {
+    if(box == NULL) {
         if (p->flags & ON_THE_GROUND) {
             Player_setState(STILL, p);
             if (p->contKeyDown & (MOV_LEFT | MOV_RIGHT))
@@ -696,55 +849,58 @@ void Player_attack(Player *p) {
     //death is an exception, we have to take care to clean up our mess
     if(p->flags & DAMAGED) {
         Player_setState(DEAD, p);
-        PH_destroyObject(p->attData.box);
-        p->attData.box = NULL;
-        p->attData.isLive = 0;
+        PH_destroyObject(box);
+        Task_stop(&p->attData.task);
     }
 }
 
-int Player_attackRemoveTimer(Uint32 delta, Timer *timer, Player *p) {
-    //the player has been destroyed
-    //the attackbox has been destroyed
-    if(Player_compState(DEAD, p) || p->attData.isLive == 0)
-        return 1;
+int Player_attackTask(Task *task, Uint32 delta, void *player) {
+    Player *p = (Player*)player;
 
-    Timer_updateDelta(delta, timer);
+    TASK_BEGIN(task);
+    //the box is removed once the attack has lasted longer than ATTACK_DURR
+    TASK_WAIT(task, ATTACK_DURR + 1);
+    PH_destroyObject(Player_getAttackBox(p));
+    TASK_END(task);
+}
 
-    //this might stay running after
-    if(Timer_getTicks(timer) > ATTACK_DURR) {
-        PH_destroyObject(p->attData.box);
-        p->attData.box = NULL;
-        p->attData.isLive = 0;
-        //returning 1, because we want the timer to be deleted
-        return 1;
-    }
+void Player_attackHitPlayer(PH_Manifold *contacts, int count, void *null) {
+    int i;
 
-    //we don't want the timer deleted yet
-    return 0;
+    for(i = 0; i < count; i++) {
+        ((Player*)contacts[i].B->userData.data)->flags |= DAMAGED;
+        ((Player*)contacts[i].A->userData.data)->score++;
+    }
 }
 
-int Player_attackBoxColl(PH_Manifold *m, Object *A, Object *B, Player *p) {
+void Player_attackHitBlock(PH_Manifold *contacts, int count, void *null) {
+    int i;
+    Player *p;
 
-    if(B->userData.type == PLAYER) {
-        ((Player*)B->userData.data)->flags |= DAMAGED;
-        p->score++;
-    } else if (B->userData.type == BLOCK) {
-        if(Bag_search(B, destroyBag) == -1 && !p->attData.usedUp) {
-            Bag_push(B, destroyBag);
+    //an attack can only break a single block
+    for(i = 0; i < count; i++) {
+        p = (Player*)contacts[i].A->userData.data;
+        if(!p->attData.usedUp && Player_destroyBlock(contacts[i].B))
             p->attData.usedUp = 1;
-        }
-    } else if (B->userData.type == ATTACKBOX) {
-        if(p->attData.relPos.x < 0) {
-            Vector2D vec = {CLING_IMPULSE, 0};
-            PH_impulse(&vec, p->phObj);
-        } else {
-            Vector2D vec = {-CLING_IMPULSE, 0};
-            PH_impulse(&vec, p->phObj);
-        }
     }
+}
 
-    //we never want our attack boxes to collide with stuff
-    return 0;
+void Player_attackHitAttack(PH_Manifold *contacts, int count, void *null) {
+    int i, j;
+    Player *p;
+
+    //both of the attackers cling back from each other
+    for(i = 0; i < count; i++)
+        for(j = 0; j < 2; j++) {
+            p = (Player*)(j == 0 ? contacts[i].A : contacts[i].B)->userData.data;
+            if(p->attData.relPos.x < 0) {
+                Vector2D vec = {CLING_IMPULSE, 0};
+                PH_impulse(&vec, p->phObj);
+            } else {
+                Vector2D vec = {-CLING_IMPULSE, 0};
+                PH_impulse(&vec, p->phObj);
+            }
+        }
 }
 
 
@@ -754,49 +910,37 @@ int Player_attackBoxColl(PH_Manifold *m, Object *A, Object *B, Player *p) {
  */
 void Player_flyMov(Player *p) {
     Vector2D vec = {0, 0};
-    AABB aabb = p->phObj->aabb;
-    vec.y = aabb.center.y - aabb.hHeight / 2;
+    //the sides touching walls, filled by the physics step
+    uint32_t contacts = p->phObj->contacts.flags;
 
     int walljump = 0;
 
     if (p->keyDown & JUMP_KEY) {
-        vec.x = aabb.center.x + aabb.hWidth + 2;
-        PH_queryPoint(vec, STATIC | HYBRID, 1, queryBag, p->world);
-        if (queryBag->elemCount != 0) {
+        if (contacts & PH_CONTACT(PH_RIGHT)) {
             p->phObj->velocity.x = -XCAP;
             p->phObj->velocity.y = JUMP_SPEED;
             walljump = 1;
-        } else {
-            vec.x = aabb.center.x - aabb.hWidth - 2;
-            PH_queryPoint(vec, STATIC | HYBRID, 1, queryBag, p->world);
-            if (queryBag->elemCount != 0) {
-                p->phObj->velocity.x = XCAP;
-                p->phObj->velocity.y = JUMP_SPEED;
-                walljump = 1;
-            }
+        } else if (contacts & PH_CONTACT(PH_LEFT)) {
+            p->phObj->velocity.x = XCAP;
+            p->phObj->velocity.y = JUMP_SPEED;
+            walljump = 1;
         }
     }
 
     if (!walljump) {
         float *velY = &p->phObj->velocity.y;
         if (p->contKeyDown & MOV_LEFT && !(p->contKeyDown & MOV_RIGHT)) {
-            vec.x = aabb.center.x - aabb.hWidth - 2;
-            PH_queryPoint(vec, STATIC | HYBRID, 1, queryBag, p->world);
-            if(queryBag->elemCount != 0) {
+            if(contacts & PH_CONTACT(PH_LEFT)) {
                 *velY = *velY < -SLIDE_MAX ? -SLIDE_MAX : *velY;
             } else {
                 vec.x = -FLY_FORCE;
-                vec.y = 0;
                 PH_force(&vec, p->phObj);
             }
         } else if (p->contKeyDown & MOV_RIGHT && !(p->contKeyDown & MOV_LEFT)) {
-            vec.x = aabb.center.x + aabb.hWidth + 2;
-            PH_queryPoint(vec, STATIC | HYBRID, 1, queryBag, p->world);
-            if(queryBag->elemCount != 0) {
+            if(contacts & PH_CONTACT(PH_RIGHT)) {
                 *velY = *velY < -SLIDE_MAX ? -SLIDE_MAX : *velY;
             } else {
                 vec.x = FLY_FORCE;
-                vec.y = 0;
                 PH_force(&vec, p->phObj);
             }
         }
@@ -817,17 +961,3 @@ void Player_groundMov(Player *p) {
         PH_force(&vec, p->phObj);
     }
 }
-
-
-
-
-
-
-
-
-
-
-
-
-
-
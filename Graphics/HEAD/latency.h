@@ -0,0 +1,72 @@
+/*
+* Copyright (C) 2015 Bendegúz Nagy
+* 
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+* 
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+* 
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "SDL2/SDL.h"
+
+/**
+ * @file
+ * @brief Measures how long input takes to reach the screen.
+ * @author Bendegúz Nagy
+ *
+ * The path of a key press is followed in three steps. LT_input() tags the event with the wall clock time it was taken
+ * at (see Input_eventTime()), LT_simulated() marks everything tagged so far as consumed by the simulation, it can be
+ * called from the physics thread too. When the events reach the simulation later, LT_simulatedUpTo() marks only the
+ * ones it has taken, by the seq LT_input() has returned for them. LT_present() presents the renderer instead of
+ * SDL_RenderPresent(), the events simulated by then get the time it returns at, their latency is the time from the
+ * input to that.
+ *
+ * Tracing is off until LT_start() is called, then the overlay shows the p50, p95, p99 and the maximum latency of the
+ * last LT_WINDOW events on the screen, and if a log file was given, every event gets a line in it. LT_getStats()
+ * returns the percentiles. LT_deinit() writes the percentiles of the whole run into the log and prints them.
+ * Initialize the module with LT_init() after TS_init(), deinitialize with LT_deinit() before TS_deinit().
+ */
+
+#ifndef LATENCY_H_INCLUDED
+#define LATENCY_H_INCLUDED
+
+/**@brief The number of latest events the overlay is calculated from.*/
+#define LT_WINDOW (128)
+/**@brief The number of events which can wait for their present at once, the oldest are dropped beyond that.*/
+#define LT_MAX_PENDING (64)
+/**@brief How often the overlay is updated, in µs.*/
+#define LT_OVERLAY_INTERVAL (500000)
+
+/**
+ * @brief Latency percentiles in µs.
+ */
+typedef struct LT_Stats {
+    int count; //the number of events the percentiles are calculated from
+    Uint32 p50;
+    Uint32 p95;
+    Uint32 p99;
+    Uint32 max;
+} LT_Stats;
+
+void LT_init();
+void LT_deinit();
+
+int LT_start(const char *logPath);
+int LT_isTracing();
+
+int LT_input(Uint64 time, int id);
+void LT_simulated();
+void LT_simulatedUpTo(int seq);
+void LT_present();
+
+LT_Stats LT_getStats(int window);
+
+#endif // LATENCY_H_INCLUDED
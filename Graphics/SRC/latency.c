@@ -0,0 +1,329 @@
+/*
+* Copyright (C) 2015 Bendegúz Nagy
+* 
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+* 
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+* 
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../HEAD/latency.h"
+#include "../HEAD/graphics_man.h"
+#include "../HEAD/textsprite.h"
+#include "../../Events/HEAD/timer.h"
+#include "../../Utility/HEAD/array.h"
+#include "../../Utility/HEAD/ring.h"
+#include "../../Utility/HEAD/frame.h"
+
+/**@brief The size of the overlay text.*/
+#define LT_TEXT_SIZE (16)
+
+/**
+ * @brief Internal, an input event waiting for the present showing it.
+ */
+typedef struct LT_Event {
+    int seq; //the number of events tagged before it
+    int id; //the id it was tagged with
+    Uint64 input; //the wall clock time in µs it was taken at
+    Uint64 simulated; //the wall clock time in µs the simulation consumed it at, 0 if it hasn't yet
+} LT_Event;
+
+/**
+ * @brief Internal, published by the simulation, the events tagged before seq have been consumed at time.
+ */
+typedef struct LT_Batch {
+    int seq;
+    Uint64 time;
+} LT_Batch;
+
+DEFINE_ARRAY(Uint32, LT_SampleArray)
+
+/**
+ * @brief Internal, set by LT_start().
+ */
+static int tracing = 0;
+static FILE *logFile = NULL;
+static Uint64 startTime = 0;
+/**
+ * @brief Internal, the events waiting for their present in the order they were tagged, a circular buffer.
+ */
+static LT_Event pending[LT_MAX_PENDING];
+static int pendingFirst = 0;
+static int pendingCount = 0;
+static int dropped = 0;
+/**
+ * @brief Internal, the number of events tagged, read by the simulation.
+ */
+static SDL_atomic_t tagged;
+/**
+ * @brief Internal, the points the simulation has got to, and the seq of the last one, owned by the simulation.
+ */
+static SPSCRing batches;
+static int simulatedSeq = 0;
+/**
+ * @brief Internal, the latency of every presented event in µs, in the order they were presented.
+ */
+static LT_SampleArray samples;
+static int presents = 0;
+/**
+ * @brief Internal, the overlay, the time it was last updated at and the number of samples it shows.
+ */
+static TextSprite *overlay = NULL;
+static Uint64 overlayTime = 0;
+static int overlayCount = 0;
+
+/**
+ * @brief Private, logs the latency of an event which has just been presented.
+ */
+void LT_record(LT_Event *ev, Uint64 presented);
+/**
+ * @brief Private, updates the overlay now and then and renders it.
+ */
+void LT_renderOverlay();
+/**
+ * @brief Private, qsort comparator, orders the latencies increasingly.
+ */
+int LT_compare(const void *a, const void *b);
+
+/**
+ * @brief Initializes the module, tracing is off until LT_start().
+ */
+void LT_init() {
+    SPSCRing_init(sizeof(LT_Batch), LT_MAX_PENDING, &batches);
+    LT_SampleArray_initTagged(MT_TAG_GRAPHICS, NULL, &samples);
+    SDL_AtomicSet(&tagged, 0);
+}
+
+/**
+ * @brief Deinitializes the module, when tracing, the percentiles of the whole run are printed and logged.
+ */
+void LT_deinit() {
+    LT_Stats s;
+
+    if(tracing) {
+        s = LT_getStats(0);
+        printf("Latency: %d events, p50 %.2f ms, p95 %.2f ms, p99 %.2f ms, max %.2f ms, %d dropped.\n", s.count,
+               s.p50 / 1000.0, s.p95 / 1000.0, s.p99 / 1000.0, s.max / 1000.0, dropped);
+        if(logFile != NULL)
+            fprintf(logFile, "# %d events, p50 %u us, p95 %u us, p99 %u us, max %u us, %d dropped\n", s.count,
+                    s.p50, s.p95, s.p99, s.max, dropped);
+    }
+
+    if(logFile != NULL)
+        fclose(logFile);
+    logFile = NULL;
+    TS_free(overlay);
+    overlay = NULL;
+    SPSCRing_free(&batches);
+    LT_SampleArray_free(&samples);
+    tracing = 0;
+}
+
+/**
+ * @brief Starts tracing, call it before the simulation is started on another thread.
+ * @param logPath The file every event is logged into, it is truncated, NULL for no log.
+ * @return 0 on success, non-zero if the log file can't be opened.
+ */
+int LT_start(const char *logPath) {
+    if(logPath != NULL) {
+        if((logFile = fopen(logPath, "wt")) == NULL) {
+            printf("FUNC: LT_start. Error opening file: %s.\n", logPath);
+            return -1;
+        }
+        //the times are in µs, the input from the start, the rest from the input
+        fprintf(logFile, "id,input_us,simulated_us,presented_us,frame\n");
+    }
+
+    overlay = TS_new();
+    startTime = getTimeUs();
+    tracing = 1;
+    return 0;
+}
+
+/**
+ * @brief Tells if the latency is being traced.
+ */
+int LT_isTracing() {
+    return tracing;
+}
+
+/**
+ * @brief Tags an input event, call it on the main thread when the event is taken.
+ * @param time The wall clock time in µs the event was taken at, see getTimeUs().
+ * @param id Identifies the event in the log, like its keycode.
+ *
+ * @return the seq of the event to be passed to LT_simulatedUpTo(), -1 if the latency isn't traced.
+ */
+int LT_input(Uint64 time, int id) {
+    LT_Event *ev;
+    int seq;
+
+    if(!tracing)
+        return -1;
+
+    //nothing is presented, like in CLOCK_MODE_FAST, the oldest are given up
+    if(pendingCount == LT_MAX_PENDING) {
+        pendingFirst = (pendingFirst + 1) % LT_MAX_PENDING;
+        pendingCount--;
+        dropped++;
+    }
+
+    ev = &pending[(pendingFirst + pendingCount++) % LT_MAX_PENDING];
+    ev->seq = seq = SDL_AtomicGet(&tagged);
+    ev->id = id;
+    ev->input = time;
+    ev->simulated = 0;
+    SDL_AtomicAdd(&tagged, 1);
+    return seq;
+}
+
+/**
+ * @brief Marks the events tagged so far as consumed by the simulation, call it after each simulation step.
+ *
+ * Use it when the simulation takes the events as soon as they are tagged. Can be called from the main thread or from
+ * the physics thread, but only from one of them at a time.
+ */
+void LT_simulated() {
+    LT_simulatedUpTo(SDL_AtomicGet(&tagged) - 1);
+}
+
+/**
+ * @brief Marks the events up to and including seq as consumed by the simulation, call it after a simulation step.
+ * @param seq The seq returned by LT_input() for the last event the step has taken.
+ *
+ * Use it when the events reach the simulation later than they are tagged, like through the queue of the physics
+ * thread. Can be called from the main thread or from the physics thread, but only from one of them at a time.
+ */
+void LT_simulatedUpTo(int seq) {
+    LT_Batch b;
+
+    if(!tracing)
+        return;
+
+    b.seq = seq + 1;
+    if(b.seq <= simulatedSeq)
+        return;
+
+    //if the queue is full, the next step tries again
+    b.time = getTimeUs();
+    if(SPSCRing_push(&b, &batches) == 0)
+        simulatedSeq = b.seq;
+}
+
+/**
+ * @brief Renders the overlay and presents the renderer, use it instead of SDL_RenderPresent().
+ */
+void LT_present() {
+    LT_Batch b;
+    LT_Event *ev;
+    Uint64 now;
+    int i;
+
+    if(!tracing) {
+        SDL_RenderPresent(gRenderer);
+        return;
+    }
+
+    LT_renderOverlay();
+    SDL_RenderPresent(gRenderer);
+    now = getTimeUs();
+    presents++;
+
+    //the simulation consumes the events in order, the ones before a batch get its time, unless they have one
+    while(SPSCRing_pop(&b, &batches) == 0)
+        for(i = 0; i < pendingCount; i++) {
+            ev = &pending[(pendingFirst + i) % LT_MAX_PENDING];
+            if(ev->seq >= b.seq)
+                break;
+            if(ev->simulated == 0)
+                ev->simulated = b.time;
+        }
+
+    //the simulated events are shown by this present
+    while(pendingCount > 0 && pending[pendingFirst].simulated != 0) {
+        LT_record(&pending[pendingFirst], now);
+        pendingFirst = (pendingFirst + 1) % LT_MAX_PENDING;
+        pendingCount--;
+    }
+}
+
+/**
+ * @brief Returns the latency percentiles of the presented events, call it on the main thread.
+ * @param window The number of latest events to be considered, 0 for all of them.
+ */
+LT_Stats LT_getStats(int window) {
+    LT_Stats s = {0, 0, 0, 0, 0};
+    Uint32 *sorted;
+    int n = samples.count;
+
+    if(window > 0 && window < n)
+        n = window;
+    if(n == 0)
+        return s;
+
+    //sorted in scratch memory, the samples stay in their order
+    sorted = (Uint32*)Frame_alloc(sizeof(Uint32) * n);
+    memcpy(sorted, samples.data + samples.count - n, sizeof(Uint32) * n);
+    qsort(sorted, (size_t)n, sizeof(Uint32), &LT_compare);
+
+    //nearest rank
+    s.count = n;
+    s.p50 = sorted[(n * 50 + 99) / 100 - 1];
+    s.p95 = sorted[(n * 95 + 99) / 100 - 1];
+    s.p99 = sorted[(n * 99 + 99) / 100 - 1];
+    s.max = sorted[n - 1];
+    return s;
+}
+
+
+//private methods
+
+
+void LT_record(LT_Event *ev, Uint64 presented) {
+    Uint64 latency = presented - ev->input;
+
+    LT_SampleArray_push(latency > 0xFFFFFFFF ? 0xFFFFFFFF : (Uint32)latency, &samples);
+    if(logFile != NULL)
+        fprintf(logFile, "%d,%llu,%llu,%llu,%d\n", ev->id, (unsigned long long)(ev->input - startTime),
+                (unsigned long long)(ev->simulated - ev->input), (unsigned long long)latency, presents);
+}
+
+void LT_renderOverlay() {
+    SDL_Color c = {0x30, 0x30, 0x30, 0xFF};
+    char text[128];
+    Uint64 now = getTimeUs();
+    LT_Stats s;
+
+    //making the texture of a text is expensive, it is only done a few times a second
+    if(samples.count != overlayCount && now - overlayTime >= LT_OVERLAY_INTERVAL) {
+        s = LT_getStats(LT_WINDOW);
+        snprintf(text, sizeof(text), "input latency p50 %.1f ms  p95 %.1f ms  p99 %.1f ms  max %.1f ms",
+                 s.p50 / 1000.0, s.p95 / 1000.0, s.p99 / 1000.0, s.max / 1000.0);
+        if(TS_setText(text, &c, LT_TEXT_SIZE, overlay) == 0)
+            TS_setPos(10, SCREEN_HEIGHT - TS_getHeight(overlay) - 10, overlay);
+        overlayCount = samples.count;
+        overlayTime = now;
+    }
+
+    //nothing to show before the first event
+    if(overlayCount > 0)
+        TS_render(overlay);
+}
+
+int LT_compare(const void *a, const void *b) {
+    Uint32 x = *(const Uint32*)a;
+    Uint32 y = *(const Uint32*)b;
+    return (x > y) - (x < y);
+}
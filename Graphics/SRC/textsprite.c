@@ -20,6 +20,7 @@
 #include "../HEAD/textsprite.h"
 #include "../HEAD/graphics_man.h"
 #include "../../Utility/HEAD/bag.h"
+#include "../../Utility/HEAD/memtrack.h"
 
 /**
  * @brief Internal representation of the global font in a given size.
@@ -57,7 +58,7 @@ void TS_freeFont(Fonts *font) {
     if(font != NULL) {
         if (font->font != NULL)
             TTF_CloseFont(font->font);
-        free(font);
+        MT_free(font);
     }
 }
 
@@ -68,7 +69,7 @@ void TS_freeFont(Fonts *font) {
  * calling TS_deinit in between will cause a memory leak.
  */
 void TS_init(char *fontPath) {
-    fontsBag = Bag_new((freeData)&TS_freeFont);
+    fontsBag = Bag_newTagged((freeData)&TS_freeFont, MT_TAG_GRAPHICS, NULL);
     fontsPath = fontPath;
 }
 
@@ -85,7 +86,7 @@ void TS_deinit() {
  * @return the newly allocated text object.
  */
 TextSprite *TS_new() {
-    TextSprite *ptr = (TextSprite *) malloc(sizeof(TextSprite));
+    TextSprite *ptr = (TextSprite *) MT_malloc(sizeof(TextSprite), MT_TAG_GRAPHICS);
     ptr->textTure = NULL;
     ptr->dest.x = ptr->dest.y = 0;
     return ptr;
@@ -101,7 +102,7 @@ void TS_free(TextSprite *ptr) {
     if (ptr->textTure != NULL)
         SDL_DestroyTexture(ptr->textTure);
 
-    free(ptr);
+    MT_free(ptr);
 }
 
 /**
@@ -124,7 +125,7 @@ int TS_setText(char *text, SDL_Color *color, int size, TextSprite *ptr) {
 
     //means we haven't initialized the font with the given size yet
     if(font == NULL)   {
-        Fonts *f = (Fonts*)malloc(sizeof(Fonts));
+        Fonts *f = (Fonts*)MT_malloc(sizeof(Fonts), MT_TAG_GRAPHICS);
         f->size = size;
         //here we create the font with the req. size
         if((f->font = TTF_OpenFont(fontsPath, size)) == NULL) {
@@ -0,0 +1,234 @@
+/*
+* Copyright (C) 2015 Bendegúz Nagy
+* 
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+* 
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+* 
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file
+ * @brief Measures the error and the throughput of the fastmath approximations against libm.
+ * @author Bendegúz Nagy
+ *
+ * The maximum error of each *Fast function is measured against the double precision libm result over a dense sweep of
+ * its documented range, and checked against twice the maximum given in fastmath.h, which leaves room for other
+ * compilers and FMA contraction, the program exits with non-zero if one is exceeded. Then the time of a call is measured on an array of inputs, for the approximation and for the single
+ * precision libm function it replaces. Build it with optimizations for meaningful timings.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include "../Utility/HEAD/fastmath.h"
+
+/**@brief The number of points each error sweep takes.*/
+#define FT_SWEEP (2000000)
+/**@brief The number of inputs the throughput is measured on, they fit the L1 cache.*/
+#define FT_INPUTS (4096)
+/**@brief The number of times the inputs are processed for a timing.*/
+#define FT_ROUNDS (5000)
+
+/**
+ * @brief Internal, the inputs and the outputs of the timings.
+ */
+static float inputX[FT_INPUTS], inputY[FT_INPUTS], outputA[FT_INPUTS], outputB[FT_INPUTS];
+/**
+ * @brief Internal, the results of the timings are summed into it, so they can't be optimized away.
+ */
+static volatile float sink;
+/**
+ * @brief Internal, the number of errors above their bound.
+ */
+static int failures = 0;
+
+/**
+ * @brief Private, prints a measured maximum error, relative or absolute, and checks it against its bound.
+ */
+void FT_report(const char *name, const char *range, int relative, double error, double bound);
+/**
+ * @brief Private, returns the CPU time in ns a call took, for elapsed clock() ticks over the whole timing.
+ */
+double FT_perCall(clock_t ticks);
+/**
+ * @brief Private, prints the time of a call of the libm function and of the approximation.
+ */
+void FT_printTimes(const char *name, clock_t libm, clock_t fast);
+/**
+ * @brief Private, measures the errors.
+ */
+void FT_testErrors();
+/**
+ * @brief Private, measures the throughput.
+ */
+void FT_benchmark();
+
+int main(int argc, char *argv[]) {
+    (void)argc;
+    (void)argv;
+
+    FT_testErrors();
+    FT_benchmark();
+
+    printf(failures == 0 ? "Every error is within its bound.\n" : "%d errors are above their bounds.\n", failures);
+    return failures != 0;
+}
+
+
+//private methods
+
+
+void FT_report(const char *name, const char *range, int relative, double error, double bound) {
+    if(error > bound)
+        failures++;
+    printf("%-8s %-22s max %s error %.3g, bound %.3g%s\n", name, range, relative ? "relative" : "absolute", error,
+           bound, error > bound ? ", FAILED" : "");
+}
+
+double FT_perCall(clock_t ticks) {
+    return (double)ticks / CLOCKS_PER_SEC / ((double)FT_ROUNDS * FT_INPUTS) * 1e9;
+}
+
+void FT_printTimes(const char *name, clock_t libm, clock_t fast) {
+    printf("%-8s libm %6.2f ns, fast %6.2f ns per call, %.1fx\n", name, FT_perCall(libm), FT_perCall(fast),
+           (double)libm / (double)(fast > 0 ? fast : 1));
+}
+
+void FT_testErrors() {
+    static const double angles[] = {FM_PI, 100.0, 1e4};
+    double error, ref, e;
+    float x, y, s, c;
+    int i, j;
+
+    //log-spaced, so every binade gets the same number of points
+    error = 0;
+    for(i = 0; i < FT_SWEEP; i++) {
+        x = (float)pow(10.0, -6.0 + 14.0 * i / FT_SWEEP);
+        ref = 1.0 / sqrt((double)x);
+        if((e = fabs(FM_rsqrtFast(x) - ref) / ref) > error)
+            error = e;
+    }
+    FT_report("rsqrt", "1e-6 <= x < 1e8", 1, error, 1e-5);
+
+    error = 0;
+    for(i = 0; i < FT_SWEEP; i++) {
+        x = (float)pow(10.0, -6.0 + 14.0 * i / FT_SWEEP) * (i % 2 ? -1.0f : 1.0f);
+        ref = 1.0 / (double)x;
+        if((e = fabs(FM_rcpFast(x) - ref) / fabs(ref)) > error)
+            error = e;
+    }
+    FT_report("rcp", "1e-6 <= |x| < 1e8", 1, error, 3e-7);
+
+    //the reduction loses precision with the size of the angle, the error is shown for a few ranges
+    for(j = 0; j < (int)(sizeof(angles) / sizeof(angles[0])); j++) {
+        char range[32];
+        error = 0;
+        for(i = 0; i < FT_SWEEP; i++) {
+            x = (float)(-angles[j] + 2.0 * angles[j] * i / FT_SWEEP);
+            FM_sincosFast(x, &s, &c);
+            if((e = fabs(s - sin((double)x))) > error)
+                error = e;
+            if((e = fabs(c - cos((double)x))) > error)
+                error = e;
+        }
+        sprintf(range, "|angle| < %g", angles[j]);
+        FT_report("sincos", range, 0, error, 2e-7);
+    }
+
+    //points on circles of different radii, the error of the angle does not depend on the distance
+    error = 0;
+    for(i = 0; i < FT_SWEEP; i++) {
+        double t = 2.0 * FM_PI * i / FT_SWEEP, r = 0.001 + 1000.0 * (i % 977) / 977.0;
+        x = (float)(r * cos(t));
+        y = (float)(r * sin(t));
+        e = fabs(FM_atan2Fast(y, x) - atan2((double)y, (double)x));
+        //-pi and pi are the same angle
+        if(e > FM_PI)
+            e = 2.0 * FM_PI - e;
+        if(e > error)
+            error = e;
+    }
+    FT_report("atan2", "every direction", 0, error, 4e-6);
+}
+
+void FT_benchmark() {
+    clock_t start, libm, fast;
+    float sum = 0;
+    int r, i;
+
+    srand(1);
+    for(i = 0; i < FT_INPUTS; i++) {
+        inputX[i] = 0.01f + (float)(rand() % 100000) * 0.37f;
+        inputY[i] = (float)(rand() % 20000 - 10000) * 0.01f;
+    }
+
+    start = clock();
+    for(r = 0; r < FT_ROUNDS; r++)
+        for(i = 0; i < FT_INPUTS; i++)
+            outputA[i] = 1.0f / sqrtf(inputX[i]);
+    libm = clock() - start;
+    sum += outputA[r % FT_INPUTS];
+    start = clock();
+    for(r = 0; r < FT_ROUNDS; r++)
+        for(i = 0; i < FT_INPUTS; i++)
+            outputA[i] = FM_rsqrtFast(inputX[i]);
+    fast = clock() - start;
+    sum += outputA[r % FT_INPUTS];
+    FT_printTimes("rsqrt", libm, fast);
+
+    start = clock();
+    for(r = 0; r < FT_ROUNDS; r++)
+        for(i = 0; i < FT_INPUTS; i++)
+            outputA[i] = 1.0f / inputX[i];
+    libm = clock() - start;
+    sum += outputA[r % FT_INPUTS];
+    start = clock();
+    for(r = 0; r < FT_ROUNDS; r++)
+        for(i = 0; i < FT_INPUTS; i++)
+            outputA[i] = FM_rcpFast(inputX[i]);
+    fast = clock() - start;
+    sum += outputA[r % FT_INPUTS];
+    FT_printTimes("rcp", libm, fast);
+
+    start = clock();
+    for(r = 0; r < FT_ROUNDS; r++)
+        for(i = 0; i < FT_INPUTS; i++) {
+            outputA[i] = sinf(inputY[i]);
+            outputB[i] = cosf(inputY[i]);
+        }
+    libm = clock() - start;
+    sum += outputA[r % FT_INPUTS] + outputB[r % FT_INPUTS];
+    start = clock();
+    for(r = 0; r < FT_ROUNDS; r++)
+        for(i = 0; i < FT_INPUTS; i++)
+            FM_sincosFast(inputY[i], &outputA[i], &outputB[i]);
+    fast = clock() - start;
+    sum += outputA[r % FT_INPUTS] + outputB[r % FT_INPUTS];
+    FT_printTimes("sincos", libm, fast);
+
+    start = clock();
+    for(r = 0; r < FT_ROUNDS; r++)
+        for(i = 0; i < FT_INPUTS; i++)
+            outputA[i] = atan2f(inputY[i], inputX[i] - 100.0f);
+    libm = clock() - start;
+    sum += outputA[r % FT_INPUTS];
+    start = clock();
+    for(r = 0; r < FT_ROUNDS; r++)
+        for(i = 0; i < FT_INPUTS; i++)
+            outputA[i] = FM_atan2Fast(inputY[i], inputX[i] - 100.0f);
+    fast = clock() - start;
+    sum += outputA[r % FT_INPUTS];
+    FT_printTimes("atan2", libm, fast);
+
+    sink = sum;
+}
@@ -0,0 +1,309 @@
+/*
+* Copyright (C) 2015 Bendegúz Nagy
+* 
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+* 
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+* 
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file
+ * @brief Measures the throughput and the latency of the lock-free rings.
+ * @author Bendegúz Nagy
+ *
+ * The cost of an element is measured on a single thread first, where the ring is never contended, then the throughput
+ * of a producer and a consumer thread, and of RB_PRODUCERS producers, each with single elements and with batches.
+ * The latency is the time a round trip takes through a pair of SPSCRings, to a thread echoing every element back,
+ * its percentiles are printed. Build it with optimizations, the numbers of a debug build say little.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "../Utility/HEAD/ring.h"
+
+/**@brief The number of elements passed through a ring by a throughput run.*/
+#define RB_COUNT (4000000)
+/**@brief The number of round trips the latency is measured with.*/
+#define RB_TRIPS (100000)
+/**@brief The number of producers of the MPSCRing.*/
+#define RB_PRODUCERS (4)
+/**@brief The capacity of the rings.*/
+#define RB_CAPACITY (1024)
+/**@brief The batch size of the batched runs.*/
+#define RB_BATCH (16)
+/**@brief The number of tries on a full or empty ring before the CPU is given to the other threads.*/
+#define RB_SPINS (1000)
+/**@brief Sent through the latency rings to stop the echo thread.*/
+#define RB_STOP (-1)
+
+/**
+ * @brief Internal, the state of a producer thread.
+ */
+typedef struct RB_Producer {
+    int count; //the number of elements it pushes
+    int batch;
+    void *ring;
+} RB_Producer;
+
+/**
+ * @brief Internal, the rings of the latency run, there and back.
+ */
+static SPSCRing ping, pong;
+
+/**
+ * @brief Private, returns the time in seconds since an arbitrary point.
+ */
+double RB_now();
+/**
+ * @brief Private, called when a ring is full or empty, spins a while then lets the other threads run.
+ *
+ * On a single core the thread at the other end only gets to run when this one lets it.
+ */
+void RB_wait(int *spins);
+/**
+ * @brief Private, pushes count elements into an SPSCRing.
+ */
+int RB_spscProducer(void *data);
+/**
+ * @brief Private, pushes count elements into an MPSCRing.
+ */
+int RB_mpscProducer(void *data);
+/**
+ * @brief Private, pops the elements of ping and pushes them into pong, until RB_STOP.
+ */
+int RB_echo(void *data);
+/**
+ * @brief Private, prints the cost of an element pushed and popped on the same thread.
+ */
+void RB_benchSingle();
+/**
+ * @brief Private, prints the throughput of a producer and a consumer thread on an SPSCRing.
+ */
+void RB_benchSPSC(int batch);
+/**
+ * @brief Private, prints the throughput of RB_PRODUCERS producers and a consumer on an MPSCRing.
+ */
+void RB_benchMPSC(int batch);
+/**
+ * @brief Private, prints the percentiles of the round trip time through two SPSCRings.
+ */
+void RB_benchLatency();
+/**
+ * @brief Private, qsort comparator, orders the times increasingly.
+ */
+int RB_compare(const void *a, const void *b);
+
+int main(int argc, char *argv[]) {
+    (void)argc;
+    (void)argv;
+    if(SDL_Init(0) != 0) {
+        printf("SDL_Init failed: %s\n", SDL_GetError());
+        return 1;
+    }
+
+    RB_benchSingle();
+    RB_benchSPSC(1);
+    RB_benchSPSC(RB_BATCH);
+    RB_benchMPSC(1);
+    RB_benchMPSC(RB_BATCH);
+    RB_benchLatency();
+
+    SDL_Quit();
+    return 0;
+}
+
+
+//private methods
+
+
+double RB_now() {
+    return (double)SDL_GetPerformanceCounter() / (double)SDL_GetPerformanceFrequency();
+}
+
+void RB_wait(int *spins) {
+    if(++*spins == RB_SPINS) {
+        *spins = 0;
+        SDL_Delay(0);
+    }
+}
+
+int RB_spscProducer(void *data) {
+    RB_Producer *p = (RB_Producer*)data;
+    int buffer[RB_BATCH] = {0};
+    int pushed = 0, n, spins = 0;
+
+    while(pushed < p->count) {
+        n = p->batch == 1 ? SPSCRing_push(buffer, (SPSCRing*)p->ring) == 0
+                          : SPSCRing_pushN(buffer, p->batch, (SPSCRing*)p->ring);
+        if(n == 0)
+            RB_wait(&spins);
+        pushed += n;
+    }
+    return 0;
+}
+
+int RB_mpscProducer(void *data) {
+    RB_Producer *p = (RB_Producer*)data;
+    int buffer[RB_BATCH] = {0};
+    int pushed = 0, n, spins = 0;
+
+    while(pushed < p->count) {
+        n = p->batch == 1 ? MPSCRing_push(buffer, (MPSCRing*)p->ring) == 0
+                          : MPSCRing_pushN(buffer, p->batch, (MPSCRing*)p->ring);
+        if(n == 0)
+            RB_wait(&spins);
+        pushed += n;
+    }
+    return 0;
+}
+
+int RB_echo(void *data) {
+    int value, spins = 0;
+
+    (void)data;
+    do {
+        while(SPSCRing_pop(&value, &ping) != 0)
+            RB_wait(&spins);
+        while(SPSCRing_push(&value, &pong) != 0)
+            RB_wait(&spins);
+    } while(value != RB_STOP);
+    return 0;
+}
+
+void RB_benchSingle() {
+    SPSCRing spsc;
+    MPSCRing mpsc;
+    int buffer[RB_BATCH] = {0};
+    double start;
+    int i;
+
+    SPSCRing_init(sizeof(int), RB_CAPACITY, &spsc);
+    MPSCRing_init(sizeof(int), RB_CAPACITY, &mpsc);
+
+    start = RB_now();
+    for(i = 0; i < RB_COUNT; i++) {
+        SPSCRing_push(buffer, &spsc);
+        SPSCRing_pop(buffer, &spsc);
+    }
+    printf("SPSC, 1 thread:                  %6.1f ns per element\n", (RB_now() - start) / RB_COUNT * 1e9);
+
+    start = RB_now();
+    for(i = 0; i < RB_COUNT; i += RB_BATCH) {
+        SPSCRing_pushN(buffer, RB_BATCH, &spsc);
+        SPSCRing_popN(buffer, RB_BATCH, &spsc);
+    }
+    printf("SPSC, 1 thread, batches of %2d:   %6.1f ns per element\n", RB_BATCH, (RB_now() - start) / RB_COUNT * 1e9);
+
+    start = RB_now();
+    for(i = 0; i < RB_COUNT; i++) {
+        MPSCRing_push(buffer, &mpsc);
+        MPSCRing_pop(buffer, &mpsc);
+    }
+    printf("MPSC, 1 thread:                  %6.1f ns per element\n", (RB_now() - start) / RB_COUNT * 1e9);
+
+    start = RB_now();
+    for(i = 0; i < RB_COUNT; i += RB_BATCH) {
+        MPSCRing_pushN(buffer, RB_BATCH, &mpsc);
+        MPSCRing_popN(buffer, RB_BATCH, &mpsc);
+    }
+    printf("MPSC, 1 thread, batches of %2d:   %6.1f ns per element\n", RB_BATCH, (RB_now() - start) / RB_COUNT * 1e9);
+
+    SPSCRing_free(&spsc);
+    MPSCRing_free(&mpsc);
+}
+
+void RB_benchSPSC(int batch) {
+    SPSCRing ring;
+    RB_Producer producer = {RB_COUNT, batch, &ring};
+    SDL_Thread *thread;
+    int buffer[RB_BATCH];
+    int popped = 0, n, spins = 0;
+    double start;
+
+    SPSCRing_init(sizeof(int), RB_CAPACITY, &ring);
+    start = RB_now();
+    thread = SDL_CreateThread(&RB_spscProducer, "producer", &producer);
+    while(popped < RB_COUNT) {
+        n = batch == 1 ? SPSCRing_pop(buffer, &ring) == 0 : SPSCRing_popN(buffer, batch, &ring);
+        if(n == 0)
+            RB_wait(&spins);
+        popped += n;
+    }
+    SDL_WaitThread(thread, NULL);
+
+    printf("SPSC, 2 threads, batches of %2d:  %6.1f M elements per s\n", batch, RB_COUNT / (RB_now() - start) / 1e6);
+    SPSCRing_free(&ring);
+}
+
+void RB_benchMPSC(int batch) {
+    MPSCRing ring;
+    RB_Producer producer = {RB_COUNT / RB_PRODUCERS, batch, &ring};
+    SDL_Thread *threads[RB_PRODUCERS];
+    int buffer[RB_BATCH];
+    int popped = 0, n, spins = 0, i;
+    double start;
+
+    MPSCRing_init(sizeof(int), RB_CAPACITY, &ring);
+    start = RB_now();
+    for(i = 0; i < RB_PRODUCERS; i++)
+        threads[i] = SDL_CreateThread(&RB_mpscProducer, "producer", &producer);
+    while(popped < producer.count * RB_PRODUCERS) {
+        n = batch == 1 ? MPSCRing_pop(buffer, &ring) == 0 : MPSCRing_popN(buffer, batch, &ring);
+        if(n == 0)
+            RB_wait(&spins);
+        popped += n;
+    }
+    for(i = 0; i < RB_PRODUCERS; i++)
+        SDL_WaitThread(threads[i], NULL);
+
+    printf("MPSC, %d producers, batches of %2d: %5.1f M elements per s\n", RB_PRODUCERS, batch,
+           producer.count * RB_PRODUCERS / (RB_now() - start) / 1e6);
+    MPSCRing_free(&ring);
+}
+
+void RB_benchLatency() {
+    double *trips = (double*)malloc(sizeof(double) * RB_TRIPS);
+    SDL_Thread *thread;
+    double start;
+    int i, value, spins = 0;
+
+    SPSCRing_init(sizeof(int), RB_CAPACITY, &ping);
+    SPSCRing_init(sizeof(int), RB_CAPACITY, &pong);
+    thread = SDL_CreateThread(&RB_echo, "echo", NULL);
+
+    for(i = 0; i < RB_TRIPS; i++) {
+        start = RB_now();
+        while(SPSCRing_push(&i, &ping) != 0)
+            RB_wait(&spins);
+        while(SPSCRing_pop(&value, &pong) != 0)
+            RB_wait(&spins);
+        trips[i] = RB_now() - start;
+    }
+
+    value = RB_STOP;
+    while(SPSCRing_push(&value, &ping) != 0)
+        RB_wait(&spins);
+    SDL_WaitThread(thread, NULL);
+
+    qsort(trips, RB_TRIPS, sizeof(double), &RB_compare);
+    printf("SPSC round trip: p50 %.0f ns, p99 %.0f ns, max %.0f ns\n", trips[RB_TRIPS / 2] * 1e9,
+           trips[RB_TRIPS / 100 * 99] * 1e9, trips[RB_TRIPS - 1] * 1e9);
+
+    SPSCRing_free(&ping);
+    SPSCRing_free(&pong);
+    free(trips);
+}
+
+int RB_compare(const void *a, const void *b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
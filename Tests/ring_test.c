@@ -0,0 +1,258 @@
+/*
+* Copyright (C) 2015 Bendegúz Nagy
+* 
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+* 
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+* 
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file
+ * @brief Stress test of the lock-free rings, exits with non-zero if an element is lost, duplicated or reordered.
+ * @author Bendegúz Nagy
+ *
+ * An SPSCRing passes a counter from a producer thread to the consumer, pushed and popped in batches of random size up
+ * to a limit, the consumer checks that every number arrives in order. An MPSCRing takes numbered elements from several
+ * producers at once, the consumer checks that the elements of each producer arrive in order and none is missing. Each
+ * is run with a range of batch sizes on a small ring, so the ring is full or empty, and wraps around, all the time.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "../Utility/HEAD/ring.h"
+
+/**@brief The number of elements passed through a ring by a run.*/
+#define RT_COUNT (200000)
+/**@brief The number of producers of the MPSCRing.*/
+#define RT_PRODUCERS (4)
+/**@brief The capacity of the rings, small so they are often full.*/
+#define RT_CAPACITY (64)
+/**@brief The largest batch tried, has to fit the ring.*/
+#define RT_MAX_BATCH (64)
+/**@brief A run fails if nothing arrives for this many ms, a lost element can leave the consumer waiting for it.*/
+#define RT_TIMEOUT (5000)
+
+/**
+ * @brief Internal, an element of the MPSCRing, tells which producer has sent it and which of its elements it is.
+ */
+typedef struct RT_Elem {
+    int producer;
+    int seq;
+} RT_Elem;
+
+/**
+ * @brief Internal, the state of a producer thread.
+ */
+typedef struct RT_Producer {
+    int id;
+    int count; //the number of elements it pushes
+    int maxBatch;
+    void *ring;
+} RT_Producer;
+
+/**
+ * @brief Private, reports a failed run and exits, the producers may still be waiting for room in the ring.
+ */
+void RT_fail(const char *ring, int maxBatch);
+/**
+ * @brief Private, called when nothing has been popped, fails the run if nothing has arrived for too long since the given tick.
+ */
+void RT_idle(Uint32 since, const char *ring, int maxBatch);
+/**
+ * @brief Private, returns a pseudo random batch size between 1 and maxBatch, the same sequence for the same seed.
+ */
+int RT_batch(unsigned int *seed, int maxBatch);
+/**
+ * @brief Private, pushes the numbers from 0 to count - 1 into an SPSCRing.
+ */
+int RT_spscProducer(void *data);
+/**
+ * @brief Private, pushes count RT_Elems into an MPSCRing, numbered from 0.
+ */
+int RT_mpscProducer(void *data);
+/**
+ * @brief Private, passes RT_COUNT numbers through an SPSCRing and checks their order.
+ */
+void RT_testSPSC(int maxBatch);
+/**
+ * @brief Private, passes RT_COUNT elements from RT_PRODUCERS threads through an MPSCRing and checks them.
+ */
+void RT_testMPSC(int maxBatch);
+
+int main(int argc, char *argv[]) {
+    static const int batches[] = {1, 2, 3, 7, 16, 33, RT_MAX_BATCH};
+    int i;
+
+    (void)argc;
+    (void)argv;
+    if(SDL_Init(0) != 0) {
+        printf("SDL_Init failed: %s\n", SDL_GetError());
+        return 1;
+    }
+
+    for(i = 0; i < (int)(sizeof(batches) / sizeof(batches[0])); i++) {
+        RT_testSPSC(batches[i]);
+        RT_testMPSC(batches[i]);
+    }
+
+    SDL_Quit();
+    printf("All ring tests passed.\n");
+    return 0;
+}
+
+
+//private methods
+
+
+void RT_fail(const char *ring, int maxBatch) {
+    printf("%s, batches up to %d: FAILED\n", ring, maxBatch);
+    exit(1);
+}
+
+void RT_idle(Uint32 since, const char *ring, int maxBatch) {
+    if(SDL_GetTicks() - since > RT_TIMEOUT) {
+        printf("nothing has arrived for %d ms\n", RT_TIMEOUT);
+        RT_fail(ring, maxBatch);
+    }
+    SDL_Delay(0);
+}
+
+int RT_batch(unsigned int *seed, int maxBatch) {
+    *seed = *seed * 1103515245u + 12345u;
+    return 1 + (int)((*seed >> 16) % (unsigned int)maxBatch);
+}
+
+int RT_spscProducer(void *data) {
+    RT_Producer *p = (RT_Producer*)data;
+    int buffer[RT_MAX_BATCH];
+    unsigned int seed = 1;
+    int next = 0, size, done, pushed, i;
+
+    while(next < p->count) {
+        size = RT_batch(&seed, p->maxBatch);
+        if(size > p->count - next)
+            size = p->count - next;
+        for(i = 0; i < size; i++)
+            buffer[i] = next + i;
+
+        //a full ring takes only a part of the batch, the rest is retried once the consumer has made room
+        for(done = 0; done < size; done += pushed)
+            if((pushed = SPSCRing_pushN(buffer + done, size - done, (SPSCRing*)p->ring)) == 0)
+                SDL_Delay(0);
+        next += size;
+    }
+    return 0;
+}
+
+int RT_mpscProducer(void *data) {
+    RT_Producer *p = (RT_Producer*)data;
+    RT_Elem buffer[RT_MAX_BATCH];
+    unsigned int seed = (unsigned int)p->id + 1;
+    int next = 0, size, done, pushed, i;
+
+    while(next < p->count) {
+        size = RT_batch(&seed, p->maxBatch);
+        if(size > p->count - next)
+            size = p->count - next;
+        for(i = 0; i < size; i++) {
+            buffer[i].producer = p->id;
+            buffer[i].seq = next + i;
+        }
+
+        for(done = 0; done < size; done += pushed)
+            if((pushed = MPSCRing_pushN(buffer + done, size - done, (MPSCRing*)p->ring)) == 0)
+                SDL_Delay(0);
+        next += size;
+    }
+    return 0;
+}
+
+void RT_testSPSC(int maxBatch) {
+    SPSCRing ring;
+    RT_Producer producer = {0, RT_COUNT, maxBatch, &ring};
+    SDL_Thread *thread;
+    int buffer[RT_MAX_BATCH];
+    unsigned int seed = 99;
+    int expected = 0, popped, i;
+    Uint32 arrived = SDL_GetTicks();
+
+    SPSCRing_init(sizeof(int), RT_CAPACITY, &ring);
+    thread = SDL_CreateThread(&RT_spscProducer, "producer", &producer);
+
+    while(expected < RT_COUNT) {
+        if((popped = SPSCRing_popN(buffer, RT_batch(&seed, maxBatch), &ring)) == 0)
+            RT_idle(arrived, "SPSC", maxBatch);
+        else
+            arrived = SDL_GetTicks();
+        for(i = 0; i < popped; i++, expected++)
+            if(buffer[i] != expected) {
+                printf("got %d instead of %d\n", buffer[i], expected);
+                RT_fail("SPSC", maxBatch);
+            }
+    }
+
+    SDL_WaitThread(thread, NULL);
+    if(SPSCRing_count(&ring) != 0) {
+        printf("%d elements too many\n", SPSCRing_count(&ring));
+        RT_fail("SPSC", maxBatch);
+    }
+    SPSCRing_free(&ring);
+    printf("SPSC, batches up to %2d: ok\n", maxBatch);
+}
+
+void RT_testMPSC(int maxBatch) {
+    MPSCRing ring;
+    RT_Producer producers[RT_PRODUCERS];
+    SDL_Thread *threads[RT_PRODUCERS];
+    int expected[RT_PRODUCERS];
+    RT_Elem buffer[RT_MAX_BATCH];
+    unsigned int seed = 99;
+    int received = 0, popped, i;
+    Uint32 arrived = SDL_GetTicks();
+    RT_Elem *e;
+
+    MPSCRing_init(sizeof(RT_Elem), RT_CAPACITY, &ring);
+    for(i = 0; i < RT_PRODUCERS; i++) {
+        producers[i].id = i;
+        producers[i].count = RT_COUNT / RT_PRODUCERS;
+        producers[i].maxBatch = maxBatch;
+        producers[i].ring = &ring;
+        expected[i] = 0;
+        threads[i] = SDL_CreateThread(&RT_mpscProducer, "producer", &producers[i]);
+    }
+
+    while(received < RT_COUNT / RT_PRODUCERS * RT_PRODUCERS) {
+        if((popped = MPSCRing_popN(buffer, RT_batch(&seed, maxBatch), &ring)) == 0)
+            RT_idle(arrived, "MPSC", maxBatch);
+        else
+            arrived = SDL_GetTicks();
+        for(i = 0; i < popped; i++) {
+            e = &buffer[i];
+            //the producers are interleaved, but each one's elements have to come in order
+            if(e->producer < 0 || e->producer >= RT_PRODUCERS || e->seq != expected[e->producer]) {
+                printf("got element %d of producer %d\n", e->seq, e->producer);
+                RT_fail("MPSC", maxBatch);
+            }
+            expected[e->producer]++;
+        }
+        received += popped;
+    }
+
+    for(i = 0; i < RT_PRODUCERS; i++)
+        SDL_WaitThread(threads[i], NULL);
+    if(MPSCRing_count(&ring) != 0) {
+        printf("%d elements too many\n", MPSCRing_count(&ring));
+        RT_fail("MPSC", maxBatch);
+    }
+    MPSCRing_free(&ring);
+    printf("MPSC, %d producers, batches up to %2d: ok\n", RT_PRODUCERS, maxBatch);
+}
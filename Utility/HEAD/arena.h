@@ -0,0 +1,83 @@
+/*
+* Copyright (C) 2015 Bendegúz Nagy
+* 
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+* 
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+* 
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file
+ * @brief Region allocator, everything allocated from an Arena is released at once.
+ * @author Bendegúz Nagy
+ *
+ * Create an arena with Arena_new(), allocate from it with Arena_alloc(), Arena_calloc() and Arena_realloc(), then
+ * release everything with Arena_reset(), which keeps the memory for the next round of allocations, or with
+ * Arena_free(). Single allocations can not be freed, Arena_realloc() only grows in place if the pointer is the latest
+ * allocation, otherwise the old memory is wasted until the reset.
+ *
+ * Modules that can work in an arena take an Arena pointer in their *In constructors, NULL standing for the heap: the
+ * Arena_* functions then fall back to malloc(), realloc() and free(). The heap fallback is tracked under
+ * MT_TAG_CONTAINER, the Arena_*Tagged functions tell the MT_TAG of the caller instead. Arenas are not thread-safe.
+ * Unless ARENA_POISON is set to zero, or NDEBUG is defined, Arena_reset() overwrites the released memory to expose
+ * dangling pointers.
+ */
+
+#ifndef DUMMY_ARENA_H
+#define DUMMY_ARENA_H
+
+#include <stddef.h>
+#include "memtrack.h"
+
+/**@brief Every allocation is aligned to this many bytes.*/
+#define ARENA_ALIGN (16)
+
+/**
+ * @brief A chunk of memory the arena allocates from, do not access directly.
+ */
+typedef struct Arena_block Arena_block;
+
+/**
+ * @brief Allocation statistics of an Arena.
+ */
+typedef struct ArenaStats {
+    size_t bytes; //bytes allocated since the last reset, including alignment
+    size_t peak; //the most bytes ever allocated between two resets
+    int count; //allocations since the last reset
+    size_t reserved; //bytes of memory held by the arena
+} ArenaStats;
+
+/**
+ * @brief Holds the blocks of an arena.
+ */
+typedef struct Arena {
+    Arena_block *first;
+    Arena_block *current; //the block allocations are taken from, the ones after it are empty
+    void *last; //the latest allocation, can be grown in place
+    size_t blockSize;
+    ArenaStats stats;
+} Arena;
+
+Arena *Arena_new(size_t blockSize);
+void Arena_free(Arena *arena);
+
+void *Arena_alloc(size_t size, Arena *arena);
+void *Arena_calloc(size_t count, size_t size, Arena *arena);
+void *Arena_realloc(void *ptr, size_t oldSize, size_t size, Arena *arena);
+void *Arena_allocTagged(size_t size, MT_TAG tag, Arena *arena);
+void *Arena_callocTagged(size_t count, size_t size, MT_TAG tag, Arena *arena);
+void *Arena_reallocTagged(void *ptr, size_t oldSize, size_t size, MT_TAG tag, Arena *arena);
+void Arena_release(void *ptr, Arena *arena);
+void Arena_reset(Arena *arena);
+ArenaStats Arena_getStats(const Arena *arena);
+
+#endif //DUMMY_ARENA_H
@@ -0,0 +1,105 @@
+/*
+* Copyright (C) 2015 Bendegúz Nagy
+* 
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+* 
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+* 
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file
+ * @brief Typed dynamically growing arrays storing their elements by value.
+ * @author Bendegúz Nagy
+ *
+ * DEFINE_ARRAY(TYPE, NAME) defines the array type NAME holding TYPE elements, with inline functions prefixed by NAME:
+ *      NAME##_init(a)                  - makes an empty array, has to be called before anything else
+ *      NAME##_initIn(arena, a)         - makes an empty array storing its elements in an Arena
+ *      NAME##_initTagged(tag, arena, a) - the same, the heap storage of a NULL arena is tracked under an MT_TAG
+ *      NAME##_free(a)                  - frees the storage, the array is empty afterwards
+ *      NAME##_reserve(size, a)         - makes room for size elements
+ *      NAME##_push(elem, a)            - copies elem to the end, returns its index
+ *      NAME##_pop(a)                   - removes and returns the last element
+ *      NAME##_unorderedRemove(index, a) - removes and returns an element, the last one is moved into its place
+ *      NAME##_clear(a)                 - removes every element, keeps the storage
+ * Iterate by accessing the implementation or with ARRAY_FOREACH(). Unlike a Bag, the array owns the elements, pointers
+ * to them are only valid until the array grows or the element is moved by an unordered remove. Arrays in an Arena
+ * don't have to be freed, but the storage they outgrow is only reclaimed by resetting the arena.
+ */
+
+#ifndef DUMMY_ARRAY_H
+#define DUMMY_ARRAY_H
+
+#include <stdlib.h>
+#include "arena.h"
+
+/**@brief The number of elements the storage is allocated for the first time.*/
+#define ARRAY_MIN_SIZE (16)
+
+/**
+ * @brief Iterates through the array a with the element pointer ptr.
+ */
+#define ARRAY_FOREACH(ptr, a) for((ptr) = (a)->data; (ptr) < (a)->data + (a)->count; (ptr)++)
+
+/**
+ * @brief Defines a typed dynamic array named NAME, holding TYPE elements, see the file description.
+ */
+#define DEFINE_ARRAY(TYPE, NAME) \
+typedef struct NAME { \
+    TYPE *data; \
+    int count; \
+    int maxSize; \
+    Arena *arena; \
+    MT_TAG tag; \
+} NAME; \
+static inline void NAME##_initTagged(MT_TAG tag, Arena *arena, NAME *a) { \
+    a->data = NULL; \
+    a->count = a->maxSize = 0; \
+    a->arena = arena; \
+    a->tag = tag; \
+} \
+static inline void NAME##_initIn(Arena *arena, NAME *a) { \
+    NAME##_initTagged(MT_TAG_CONTAINER, arena, a); \
+} \
+static inline void NAME##_init(NAME *a) { \
+    NAME##_initIn(NULL, a); \
+} \
+static inline void NAME##_free(NAME *a) { \
+    Arena_release(a->data, a->arena); \
+    NAME##_initTagged(a->tag, a->arena, a); \
+} \
+static inline void NAME##_reserve(int size, NAME *a) { \
+    if(size > a->maxSize) { \
+        a->data = (TYPE*)Arena_reallocTagged(a->data, sizeof(TYPE) * a->maxSize, sizeof(TYPE) * size, a->tag, \
+                                             a->arena); \
+        a->maxSize = size; \
+    } \
+} \
+static inline int NAME##_push(TYPE elem, NAME *a) { \
+    /*double the size if full, the same as a Bag*/ \
+    if(a->count == a->maxSize) \
+        NAME##_reserve(a->maxSize ? a->maxSize * 2 : ARRAY_MIN_SIZE, a); \
+    a->data[a->count] = elem; \
+    return a->count++; \
+} \
+static inline TYPE NAME##_pop(NAME *a) { \
+    return a->data[--a->count]; \
+} \
+static inline TYPE NAME##_unorderedRemove(int index, NAME *a) { \
+    TYPE elem = a->data[index]; \
+    a->data[index] = a->data[--a->count]; \
+    return elem; \
+} \
+static inline void NAME##_clear(NAME *a) { \
+    a->count = 0; \
+}
+
+#endif //DUMMY_ARRAY_H
@@ -23,16 +23,26 @@
  * Create a new dynamic array with Bag_new(), add element with Bag_push(), remove with
  * Bag_unordered() remove. Iterate by accessing the implementation. Search by pointer equality
  * with Bag_search()
+ *
+ * The first BAG_INLINE_SIZE elements are stored in the Bag itself, so small bags cost a single allocation. Make room
+ * in advance with Bag_reserve(), give back unused memory with Bag_shrinkToFit(). Bags must not be copied by value.
+ * Bags created with Bag_newIn() live in an Arena, they don't have to be freed unless they hold data to free. The heap
+ * allocations of bags created with Bag_newTagged() are tracked under the given MT_TAG.
  */
 
 #ifndef DUMMY_BAG_H
 #define DUMMY_BAG_H
 
+#include "arena.h"
+
 /**
  * @brief Bags can have a data freeing function which have to adhere to this signature.
  */
 typedef void (*freeData)(void *ptr);
 
+/**@brief The number of elements a Bag can hold without allocating its vector.*/
+#define BAG_INLINE_SIZE (4)
+
 /**
  * @brief Holds a dynamically growing array.
  */
@@ -41,9 +51,14 @@ typedef struct Bag {
     int elemCount;
     int maxSize;
     freeData freeDataPtr;
+    Arena *arena; //where the bag and its vector are allocated, NULL for the heap
+    MT_TAG tag; //the heap allocations are tracked under it
+    void *inlineVector[BAG_INLINE_SIZE]; //the vector while the bag is small, do not access directly
 } Bag;
 
 Bag *Bag_new(freeData freeDatPtr);
+Bag *Bag_newIn(freeData freeDataPtr, Arena *arena);
+Bag *Bag_newTagged(freeData freeDataPtr, MT_TAG tag, Arena *arena);
 void Bag_free(Bag *bag, int freeData);
 
 int Bag_push(void *data, Bag *bag);
@@ -51,5 +66,7 @@ void *Bag_unorderedRemove(int index, Bag *bag);
 int Bag_search(void *data, Bag *bag);
 void Bag_slowClear(Bag *bag, int free);
 void Bag_fastClear(Bag *bag);
+void Bag_reserve(int size, Bag *bag);
+void Bag_shrinkToFit(Bag *bag);
 
 #endif //DUMMY_BAG_H
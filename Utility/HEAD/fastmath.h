@@ -0,0 +1,171 @@
+/*
+* Copyright (C) 2015 Bendegúz Nagy
+* 
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+* 
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+* 
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file
+ * @brief Single precision math functions with selectable precision.
+ * @author Bendegúz Nagy
+ *
+ * FM_rsqrt(), FM_rcp(), FM_sincos() and FM_atan2() call libm (or divide) by default. Compiling with FM_FAST_MATH set to
+ * non-zero switches them to the approximations below, which are always available by their *Fast names too. Everything
+ * is branch-free apart from the zero check of FM_atan2Fast(), so loops calling them can be vectorized. Maximum errors:
+ *      FM_rsqrtFast    - bit trick and two Newton steps, 5e-6 relative
+ *      FM_rcpFast      - bit trick and three Newton steps, 1.5e-7 relative
+ *      FM_sincosFast   - Cody-Waite reduction to [-pi/4, pi/4] and minimax polynomials, 1e-7 absolute for |angle| < 1e4
+ *      FM_atan2Fast    - reduction to [0, 1] and a degree 11 odd polynomial, 2e-6 radians
+ * The approximations don't handle infinities, NaNs and denormals, rsqrt and rcp of zero are undefined. On x86 a divide
+ * is pipelined well enough that FM_rcpFast() is only a win where the division is on the critical path.
+ *
+ * Do not build code using FM_sincosFast() with -ffast-math, or at least add -fno-associative-math after it. The
+ * reduction subtracts the three parts of pi/2 one after the other, reassociated they become a single inexact multiple,
+ * and the error grows with the angle, to about 6e-6 at 100 and 1e-3 at 1e4. The CMake build adds the flag.
+ */
+
+#ifndef DUMMY_FASTMATH_H
+#define DUMMY_FASTMATH_H
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+//set this to non-zero to use the approximations instead of libm
+#ifndef FM_FAST_MATH
+#define FM_FAST_MATH 0
+#endif
+
+#define FM_PI (3.14159265358979f)
+#define FM_PI_2 (1.57079632679490f)
+
+/**
+ * @brief Approximates 1 / sqrt(x) for x > 0.
+ */
+static inline float FM_rsqrtFast(float x) {
+    //the integer interpretation of a float is roughly its scaled and biased logarithm, halving and negating it gives
+    //an estimate within 3.5%, each Newton-Raphson step then doubles the number of correct bits
+    uint32_t i;
+    float y;
+    memcpy(&i, &x, sizeof(i));
+    i = 0x5F375A86u - (i >> 1);
+    memcpy(&y, &i, sizeof(y));
+    y = y * (1.5f - 0.5f * x * y * y);
+    return y * (1.5f - 0.5f * x * y * y);
+}
+
+/**
+ * @brief Approximates 1 / x for x != 0.
+ */
+static inline float FM_rcpFast(float x) {
+    //the same trick as FM_rsqrtFast(), negating the logarithm gives an estimate within 12%
+    uint32_t i;
+    float y;
+    memcpy(&i, &x, sizeof(i));
+    i = 0x7EF311C3u - i;
+    memcpy(&y, &i, sizeof(y));
+    y = y * (2.0f - x * y);
+    y = y * (2.0f - x * y);
+    return y * (2.0f - x * y);
+}
+
+/**
+ * @brief Approximates the sine and the cosine of an angle at once.
+ * @param angle The angle in radians.
+ * @param s Where the sine is written.
+ * @param c Where the cosine is written.
+ */
+static inline void FM_sincosFast(float angle, float *s, float *c) {
+    //reduce to r in [-pi/4, pi/4] by subtracting a multiple of pi/2, pi/2 is split in three so the products are exact
+    int q = (int)(angle * 0.636619772f + (angle < 0.0f ? -0.5f : 0.5f));
+    float k = (float)q;
+    float r = ((angle - k * 1.5703125f) - k * 4.83751297e-4f) - k * 7.54978995e-8f;
+    float r2 = r * r;
+    //minimax polynomials on [-pi/4, pi/4]
+    float ps = r + r * r2 * (-1.6666654611e-1f + r2 * (8.3321608736e-3f + r2 * -1.9515295891e-4f));
+    float pc = 1.0f - 0.5f * r2 + r2 * r2 * (4.166664568e-2f + r2 * (-1.388731625e-3f + r2 * 2.443315711e-5f));
+    //rotate by the quadrant, without branches so loops calling it can be vectorized
+    float sv = (q & 1) ? pc : ps, cv = (q & 1) ? ps : pc;
+    *s = (q & 2) ? -sv : sv;
+    *c = ((q + 1) & 2) ? -cv : cv;
+}
+
+/**
+ * @brief Approximates atan2(y, x), the angle of the vector (x, y) in [-pi, pi], 0 for the null vector.
+ */
+static inline float FM_atan2Fast(float y, float x) {
+    float ax = fabsf(x), ay = fabsf(y);
+    float mx = ax > ay ? ax : ay, mn = ax > ay ? ay : ax;
+    float z, z2, r;
+
+    if(mx == 0.0f)
+        return 0.0f;
+    //atan of the ratio in [0, 1], the rest follows from symmetry
+    z = mn / mx;
+    z2 = z * z;
+    r = z * (0.99997726f + z2 * (-0.33262347f + z2 * (0.19354346f + z2 * (-0.11643287f + z2 * (0.05265332f +
+            z2 * -0.01172120f)))));
+    if(ay > ax)
+        r = FM_PI_2 - r;
+    if(x < 0.0f)
+        r = FM_PI - r;
+    return y < 0.0f ? -r : r;
+}
+
+/**
+ * @brief 1 / sqrt(x), see the file description for the precision.
+ */
+static inline float FM_rsqrt(float x) {
+#if FM_FAST_MATH
+    return FM_rsqrtFast(x);
+#else
+    return 1.0f / sqrtf(x);
+#endif
+}
+
+/**
+ * @brief 1 / x, see the file description for the precision.
+ */
+static inline float FM_rcp(float x) {
+#if FM_FAST_MATH
+    return FM_rcpFast(x);
+#else
+    return 1.0f / x;
+#endif
+}
+
+/**
+ * @brief The sine and cosine of an angle, see the file description for the precision.
+ */
+static inline void FM_sincos(float angle, float *s, float *c) {
+#if FM_FAST_MATH
+    FM_sincosFast(angle, s, c);
+#else
+    *s = sinf(angle);
+    *c = cosf(angle);
+#endif
+}
+
+/**
+ * @brief atan2(y, x), see the file description for the precision.
+ */
+static inline float FM_atan2(float y, float x) {
+#if FM_FAST_MATH
+    return FM_atan2Fast(y, x);
+#else
+    return atan2f(y, x);
+#endif
+}
+
+#endif //DUMMY_FASTMATH_H
@@ -0,0 +1,47 @@
+/*
+* Copyright (C) 2015 Bendegúz Nagy
+* 
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+* 
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+* 
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file
+ * @brief Scratch memory which only lives until the end of the current frame.
+ * @author Bendegúz Nagy
+ *
+ * Initialize the module with Frame_init(), deinitialize with Frame_deinit(). The main loop calls Frame_reset() once
+ * per iteration, which releases everything allocated in the frame at once. Grab temporary memory with Frame_alloc()
+ * or Frame_calloc(), build temporary arrays and bags in Frame_arena(). Nothing is freed one by one, and once the
+ * memory has grown to what a frame needs, no frame touches the heap again.
+ *
+ * Frame memory belongs to the main thread, the physics thread must not allocate from it. In debug builds the released
+ * memory is overwritten (see ARENA_POISON), so anything keeping a pointer to it past the frame reads garbage.
+ */
+
+#ifndef DUMMY_FRAME_H
+#define DUMMY_FRAME_H
+
+#include <stddef.h>
+#include "arena.h"
+
+void Frame_init(size_t blockSize);
+void Frame_deinit();
+
+void *Frame_alloc(size_t size);
+void *Frame_calloc(size_t count, size_t size);
+Arena *Frame_arena();
+void Frame_reset();
+ArenaStats Frame_getStats();
+
+#endif //DUMMY_FRAME_H
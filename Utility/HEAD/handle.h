@@ -0,0 +1,110 @@
+/*
+* Copyright (C) 2015 Bendegúz Nagy
+* 
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+* 
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+* 
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file
+ * @brief Generational handles, references which can tell if what they refer to is gone.
+ * @author Bendegúz Nagy
+ *
+ * A HandleTable maps Handles to pointers. HandleTable_add() stores a pointer and returns its Handle,
+ * HandleTable_get() returns the pointer, or NULL once it has been removed with HandleTable_remove(), and
+ * HandleTable_isValid() tells if a Handle is still valid, for tables only tracking lifetimes. A Handle is the index of
+ * a slot and the generation of the slot when the Handle was made, removing bumps the generation, so every older
+ * Handle of the slot goes stale. Validation and lookup are O(1).
+ *
+ * Handles are 32 bit integers, HANDLE_NULL is never valid. They fit in a pointer, so they can be passed through state
+ * pointers with HANDLE_TO_PTR() and HANDLE_FROM_PTR(). Freed slots are reused in the order they were freed, a stale
+ * Handle would only become valid again after its slot is reused HANDLE_GENERATIONS times.
+ */
+
+#ifndef DUMMY_HANDLE_H
+#define DUMMY_HANDLE_H
+
+#include <stdint.h>
+#include "array.h"
+
+/**
+ * @brief A reference to a pointer stored in a HandleTable.
+ */
+typedef uint32_t Handle;
+
+/**@brief The Handle referring to nothing.*/
+#define HANDLE_NULL ((Handle)0)
+/**@brief The number of bits of the slot index, the rest is the generation.*/
+#define HANDLE_INDEX_BITS (20)
+/**@brief The maximum number of slots of a table.*/
+#define HANDLE_MAX_SLOTS (1 << HANDLE_INDEX_BITS)
+/**@brief The number of generations a slot goes through before wrapping around, 0 is never used.*/
+#define HANDLE_GENERATIONS ((1 << (32 - HANDLE_INDEX_BITS)) - 1)
+
+/**@brief The slot index of a Handle, tables of things living alongside a HandleTable can be indexed by it.*/
+#define HANDLE_INDEX(h) ((int)((h) & (HANDLE_MAX_SLOTS - 1)))
+
+#define HANDLE_TO_PTR(h) ((void*)(uintptr_t)(h))
+#define HANDLE_FROM_PTR(p) ((Handle)(uintptr_t)(p))
+
+/**
+ * @brief A slot of a HandleTable, do not access directly.
+ */
+typedef struct HandleSlot {
+    void *ptr;
+    uint32_t generation; //only the Handles made with the current generation are valid
+    int nextFree; //the next slot in the free list, -1 at the end, -2 if the slot is in use
+} HandleSlot;
+
+DEFINE_ARRAY(HandleSlot, HandleSlotArray)
+
+/**
+ * @brief Holds the slots, the free ones are linked in the order they were freed.
+ */
+typedef struct HandleTable {
+    HandleSlotArray slots;
+    int freeHead;
+    int freeTail;
+    int count; //the number of valid handles
+} HandleTable;
+
+void HandleTable_init(HandleTable *table);
+void HandleTable_initIn(Arena *arena, HandleTable *table);
+void HandleTable_initTagged(MT_TAG tag, Arena *arena, HandleTable *table);
+void HandleTable_free(HandleTable *table);
+
+Handle HandleTable_add(void *ptr, HandleTable *table);
+int HandleTable_remove(Handle handle, HandleTable *table);
+int HandleTable_set(Handle handle, void *ptr, HandleTable *table);
+void HandleTable_clear(HandleTable *table);
+
+/**
+ * @brief Tells if a Handle is still valid.
+ * @return non-zero if the Handle has not been removed, 0 for HANDLE_NULL.
+ */
+static inline int HandleTable_isValid(Handle handle, const HandleTable *table) {
+    uint32_t index = handle & (HANDLE_MAX_SLOTS - 1);
+
+    //a free slot is always a generation ahead of its last Handle
+    return index < (uint32_t)table->slots.count && table->slots.data[index].generation == handle >> HANDLE_INDEX_BITS;
+}
+
+/**
+ * @brief Returns the pointer stored for a Handle.
+ * @return the pointer, NULL if the Handle is stale or HANDLE_NULL.
+ */
+static inline void *HandleTable_get(Handle handle, const HandleTable *table) {
+    return HandleTable_isValid(handle, table) ? table->slots.data[handle & (HANDLE_MAX_SLOTS - 1)].ptr : NULL;
+}
+
+#endif //DUMMY_HANDLE_H
@@ -0,0 +1,65 @@
+/*
+* Copyright (C) 2015 Bendegúz Nagy
+* 
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+* 
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+* 
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file
+ * @brief Pointer keyed hash map with open addressing, can be used as a set.
+ * @author Bendegúz Nagy
+ *
+ * Create a new map with HashMap_new(), add or update keys with HashMap_insert(), look them up with HashMap_get() or
+ * HashMap_contains(), remove them with HashMap_erase(). Each key has an int value, sets simply ignore it. NULL can
+ * not be a key. HashMap_clear() removes every key, but keeps the storage, so a map can be refilled every frame
+ * without allocating. Maps created with HashMap_newIn() live in an Arena and don't have to be freed, the ones created
+ * with HashMap_newTagged() on the heap are tracked under the given MT_TAG.
+ */
+
+#ifndef DUMMY_HASHMAP_H
+#define DUMMY_HASHMAP_H
+
+#include "arena.h"
+
+/**
+ * @brief A slot of a HashMap, empty if the key is NULL.
+ */
+typedef struct HashMap_entry {
+    void *key;
+    int value;
+} HashMap_entry;
+
+/**
+ * @brief Holds the slots of a hash map, linear probing, the capacity is always a power of two.
+ */
+typedef struct HashMap {
+    HashMap_entry *entries;
+    int elemCount;
+    int capacity;
+    Arena *arena; //where the map and its slots are allocated, NULL for the heap
+    MT_TAG tag; //the heap allocations are tracked under it
+} HashMap;
+
+HashMap *HashMap_new();
+HashMap *HashMap_newIn(Arena *arena);
+HashMap *HashMap_newTagged(MT_TAG tag, Arena *arena);
+void HashMap_free(HashMap *map);
+
+int HashMap_insert(void *key, int value, HashMap *map);
+int HashMap_get(void *key, int *value, HashMap *map);
+int HashMap_contains(void *key, HashMap *map);
+int HashMap_erase(void *key, HashMap *map);
+void HashMap_clear(HashMap *map);
+
+#endif //DUMMY_HASHMAP_H
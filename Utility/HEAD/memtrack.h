@@ -0,0 +1,96 @@
+/*
+* Copyright (C) 2015 Bendegúz Nagy
+* 
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+* 
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+* 
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file
+ * @brief Opt-in heap allocation tracking, per tag and per frame.
+ * @author Bendegúz Nagy
+ *
+ * Every heap allocation of the codebase goes through MT_malloc(), MT_calloc(), MT_realloc() and MT_free(), each
+ * allocation is tagged with the MT_TAG of the module making it. By default these are plain malloc(), calloc(),
+ * realloc() and free(). Compiling everything with MT_TRACKING set to non-zero puts a small header in front of each
+ * allocation, so live bytes, peak bytes and allocation and free counts can be kept per tag. The statistics are
+ * queryable at runtime with MT_getStats(), the ones of the last finished frame with MT_getFrameStats(), frames are
+ * ended by MT_endFrame(). MT_reportLeaks() prints what is still allocated.
+ *
+ * Memory allocated by the MT_ functions has to be freed by MT_free(), and the other way around. The heap fallback of
+ * the Arena_* functions, which serves the containers and modules working in a NULL arena, is tagged by the caller
+ * through the Arena_*Tagged functions and the *Tagged constructors of the containers, MT_TAG_CONTAINER otherwise. The
+ * blocks of the arenas themselves are tagged MT_TAG_ARENA, allocations from an arena are counted by its ArenaStats.
+ * Memory allocated by SDL is not tracked. With tracking on, the statistics are guarded by a spinlock, any thread may
+ * allocate.
+ */
+
+#ifndef DUMMY_MEMTRACK_H
+#define DUMMY_MEMTRACK_H
+
+#include <stdlib.h>
+
+//set this to non-zero to track the heap allocations, has to be the same for every file
+#ifndef MT_TRACKING
+#define MT_TRACKING 0
+#endif
+
+/**
+ * @brief Tags telling which module an allocation belongs to.
+ */
+typedef enum MT_TAG {
+    MT_TAG_OTHER,
+    MT_TAG_CONTAINER, //Bag, HashMap, the arrays, the rings and the heap fallback of the arenas, unless tagged otherwise
+    MT_TAG_ARENA, //the blocks of the arenas
+    MT_TAG_PHYSICS,
+    MT_TAG_TIMER,
+    MT_TAG_INPUT,
+    MT_TAG_GRAPHICS,
+    MT_TAG_TOTAL
+} MT_TAG;
+
+/**
+ * @brief Allocation statistics of a tag, or of a single frame of a tag.
+ */
+typedef struct MT_Stats {
+    size_t live; //bytes allocated at the moment, at the end of the frame for frame statistics
+    size_t peak; //the most bytes allocated at once, during the frame for frame statistics
+    int count; //allocations alive at the moment, at the end of the frame for frame statistics
+    int allocs; //allocations made, resizes included, during the frame for frame statistics
+    int frees; //allocations freed, during the frame for frame statistics
+    size_t bytes; //bytes requested by the allocations, during the frame for frame statistics
+} MT_Stats;
+
+#if MT_TRACKING
+
+void *MT_malloc(size_t size, MT_TAG tag);
+void *MT_calloc(size_t count, size_t size, MT_TAG tag);
+void *MT_realloc(void *ptr, size_t size, MT_TAG tag);
+void MT_free(void *ptr);
+
+#else
+
+#define MT_malloc(size, tag) malloc(size)
+#define MT_calloc(count, size, tag) calloc(count, size)
+#define MT_realloc(ptr, size, tag) realloc(ptr, size)
+#define MT_free(ptr) free(ptr)
+
+#endif
+
+MT_Stats MT_getStats(MT_TAG tag);
+MT_Stats MT_getFrameStats(MT_TAG tag);
+const char *MT_tagName(MT_TAG tag);
+void MT_endFrame();
+int MT_reportLeaks();
+
+#endif //DUMMY_MEMTRACK_H
@@ -0,0 +1,99 @@
+/*
+* Copyright (C) 2015 Bendegúz Nagy
+* 
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+* 
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+* 
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file
+ * @brief Lock-free ring buffers passing fixed size elements between threads.
+ * @author Bendegúz Nagy
+ *
+ * An SPSCRing connects a single producer thread to a single consumer thread, an MPSCRing takes elements from any
+ * number of producer threads. Elements are copied in and out, the capacity is rounded up to a power of two and nothing
+ * is allocated after the init. Neither ring ever blocks: pushing into a full ring and popping from an empty one return
+ * less elements than asked for, retrying or dropping them is up to the caller.
+ *
+ * The indices written by the different sides live on their own cache lines. The SPSCRing sides also keep a copy of
+ * each other's index, so as long as the ring is neither full nor empty, they don't touch each other's cache line.
+ * Publishing an index is an atomic exchange, the *N functions move a whole batch for the price of a single one. On an
+ * MPSCRing producers claim their slots with a compare and swap and mark each slot written, so the consumer only sees
+ * the elements of a producer once they are complete, even if a later claimed batch has been finished earlier.
+ */
+
+#ifndef DUMMY_RING_H
+#define DUMMY_RING_H
+
+#include <stddef.h>
+#include <SDL2/SDL.h>
+
+/**@brief Assumed cache line size, the indices of the different sides are this far apart.*/
+#define RING_CACHE_LINE (64)
+
+/**
+ * @brief Single producer, single consumer ring.
+ */
+typedef struct SPSCRing {
+    unsigned char *buffer;
+    size_t elemSize;
+    unsigned int mask; //capacity - 1
+    char pad0[RING_CACHE_LINE];
+
+    //written by the producer
+    SDL_atomic_t tail; //next free slot
+    unsigned int headCache; //the head as last seen by the producer
+    char pad1[RING_CACHE_LINE];
+
+    //written by the consumer
+    SDL_atomic_t head; //next element to be popped
+    unsigned int tailCache; //the tail as last seen by the consumer
+    char pad2[RING_CACHE_LINE];
+} SPSCRing;
+
+/**
+ * @brief Multiple producer, single consumer ring.
+ */
+typedef struct MPSCRing {
+    unsigned char *buffer;
+    SDL_atomic_t *ready; //index of the element in each slot + 1, once it is written
+    size_t elemSize;
+    unsigned int mask; //capacity - 1
+    char pad0[RING_CACHE_LINE];
+
+    //claimed by the producers
+    SDL_atomic_t tail; //next slot to be claimed
+    char pad1[RING_CACHE_LINE];
+
+    //written by the consumer
+    SDL_atomic_t head; //next element to be popped
+    char pad2[RING_CACHE_LINE];
+} MPSCRing;
+
+void SPSCRing_init(size_t elemSize, int capacity, SPSCRing *ring);
+void SPSCRing_free(SPSCRing *ring);
+int SPSCRing_push(const void *elem, SPSCRing *ring);
+int SPSCRing_pushN(const void *elems, int count, SPSCRing *ring);
+int SPSCRing_pop(void *elem, SPSCRing *ring);
+int SPSCRing_popN(void *elems, int count, SPSCRing *ring);
+int SPSCRing_count(SPSCRing *ring);
+
+void MPSCRing_init(size_t elemSize, int capacity, MPSCRing *ring);
+void MPSCRing_free(MPSCRing *ring);
+int MPSCRing_push(const void *elem, MPSCRing *ring);
+int MPSCRing_pushN(const void *elems, int count, MPSCRing *ring);
+int MPSCRing_pop(void *elem, MPSCRing *ring);
+int MPSCRing_popN(void *elems, int count, MPSCRing *ring);
+int MPSCRing_count(MPSCRing *ring);
+
+#endif //DUMMY_RING_H
@@ -19,12 +19,20 @@
  * @file
  * @brief Basic library for handling 2D vectors represented by float co-ordinates.
  * @author Bendegúz Nagy
+ *
+ * The vector math is defined inline in this header, so the compiler can inline and vectorize it at the call site,
+ * everything is computed in single precision. The VEC2D_*N functions process arrays of vectors, using SSE or AVX when
+ * the target supports it, the arrays may alias as long as they are the same.
  */
 
 
 #ifndef VECTOR_H_INCLUDED
 #define VECTOR_H_INCLUDED
 
+#include <math.h>
+#include "array.h"
+#include "fastmath.h"
+
 /**
  * @brief Represents two vectors in floats, for performance reasons.
  */
@@ -33,6 +41,11 @@ typedef struct {
     float y;
 } Vector2D;
 
+/**
+ * @brief A dynamic array of vectors stored by value, see array.h.
+ */
+DEFINE_ARRAY(Vector2D, Vector2DArray)
+
 /**
  * @brief Allocates a new Vector.
  * @param x initial x coordinate.
@@ -59,56 +72,114 @@ void VEC2D_free(Vector2D *ptr);
  * @brief Adds two vectors together.
  * @return the resulting vector.
  */
-Vector2D VEC2D_add(const Vector2D *srcA, const Vector2D *srcB);
+static inline Vector2D VEC2D_add(const Vector2D *srcA, const Vector2D *srcB) {
+    Vector2D vec = {srcA->x + srcB->x, srcA->y + srcB->y};
+    return vec;
+}
 
 /**
  * @brief Subtract the second vector from the first vector.
  * @param srcA the second to be subtracted from.
  * @return the resulting vector.
  */
-Vector2D VEC2D_sub(const Vector2D *srcA, const Vector2D *srcB);
+static inline Vector2D VEC2D_sub(const Vector2D *srcA, const Vector2D *srcB) {
+    Vector2D vec = {srcA->x - srcB->x, srcA->y - srcB->y};
+    return vec;
+}
 
 /**
  * @brief Scale a vector with a given scalar.
  * @return the resulting vector.
  */
-Vector2D VEC2D_scale(Vector2D *srcA, float scale);
+static inline Vector2D VEC2D_scale(const Vector2D *srcA, float scale) {
+    Vector2D vec = {srcA->x * scale, srcA->y * scale};
+    return vec;
+}
+
+/**
+ * @brief Add a vector scaled by a given scalar to another vector, like integrating a velocity over time.
+ * @return the resulting vector.
+ */
+static inline Vector2D VEC2D_integrate(const Vector2D *srcA, const Vector2D *srcInteg, float scale) {
+    Vector2D vec = {srcA->x + srcInteg->x * scale, srcA->y + srcInteg->y * scale};
+    return vec;
+}
 
 /**
  * @brief Rotate a vector by a given angle.
  * @return the resulting vector.
  */
-Vector2D VEC2D_rotate(Vector2D *srcA, float angle);
+static inline Vector2D VEC2D_rotate(const Vector2D *srcA, float angle) {
+    float s, c;
+    Vector2D vec;
+    FM_sincos(angle, &s, &c);
+    vec.x = srcA->x * c - srcA->y * s;
+    vec.y = srcA->x * s + srcA->y * c;
+    return vec;
+}
+
+/**
+ * @brief Calculate the dot product of from two vectors.
+ * @return the calculated dot product.
+ */
+static inline float VEC2D_scalar(const Vector2D *a, const Vector2D *b) {
+    return a->x * b->x + a->y * b->y;
+}
+
+/**
+ * @brief Get the squared length of a vector, cheaper than VEC2D_length().
+ * @return the squared length of a vector.
+ */
+static inline float VEC2D_lSquared(const Vector2D *src) {
+    return src->x * src->x + src->y * src->y;
+}
+
+/**
+ * @brief Get the length of a vecotor.
+ * @return the length of a vector.
+ */
+static inline float VEC2D_length(const Vector2D *src) {
+    return sqrtf(src->x * src->x + src->y * src->y);
+}
 
 /**
  * @brief Normalize a vector.
  * @return the resulting vector.
  */
-Vector2D VEC2D_normalize(Vector2D *srcA);
+static inline Vector2D VEC2D_normalize(const Vector2D *srcA) {
+    return VEC2D_scale(srcA, FM_rsqrt(VEC2D_lSquared(srcA)));
+}
 
 /**
  * @brief Calculate the distance between two points defined by two vectors.
  * @return the distance.
  */
-float VEC2D_distance(Vector2D *a, Vector2D *b);
+static inline float VEC2D_distance(const Vector2D *a, const Vector2D *b) {
+    Vector2D tmp = VEC2D_sub(a, b);
+    return VEC2D_length(&tmp);
+}
 
 /**
- * @brief Calculate the dot product of from two vectors.
- * @return the calculated dot product.
+ * @brief Get the angle between a vector and the X axis.
+ * @return the angle of a vector in radians, in [-pi, pi].
  */
-float VEC2D_scalar(Vector2D *a, Vector2D *b);
+static inline float VEC2D_angle(const Vector2D *src) {
+    return FM_atan2(src->y, src->x);
+}
 
 /**
- * @brief Get the angle between a vector and the X axis.
- * @return the angle of a vector.
+ * @brief dst[i] = a[i] + b[i] for n vectors.
  */
-float VEC2D_angle(Vector2D *src);
+void VEC2D_addN(Vector2D *dst, const Vector2D *a, const Vector2D *b, int n);
 
 /**
- * @brief Get the length of a vecotor.
- * @return the length of a vector.
+ * @brief dst[i] = src[i] * scale for n vectors.
  */
-float VEC2D_length(Vector2D *src);
+void VEC2D_scaleN(Vector2D *dst, const Vector2D *src, float scale, int n);
 
-#endif // VECTOR_H_INCLUDED
+/**
+ * @brief dst[i] += src[i] * scale for n vectors, e.g. positions += velocities * delta.
+ */
+void VEC2D_integrateN(Vector2D *dst, const Vector2D *src, float scale, int n);
 
+#endif // VECTOR_H_INCLUDED
@@ -0,0 +1,245 @@
+/*
+* Copyright (C) 2015 Bendegúz Nagy
+* 
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+* 
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+* 
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include "../HEAD/arena.h"
+#include "../HEAD/memtrack.h"
+
+//set this to non-zero to overwrite the memory released by Arena_reset(), on by default in debug builds
+#ifndef ARENA_POISON
+#ifdef NDEBUG
+#define ARENA_POISON 0
+#else
+#define ARENA_POISON 1
+#endif
+#endif
+
+/**@brief Released memory is filled with this byte, floats read from it are huge negative numbers.*/
+#define ARENA_POISON_BYTE (0xDD)
+
+/**
+ * @brief Rounds a size up to the alignment of the allocations.
+ */
+#define ARENA_ROUND(size) (((size) + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1))
+
+/**
+ * @brief The header of a block, the memory handed out follows it.
+ */
+struct Arena_block {
+    Arena_block *next;
+    size_t size; //bytes after the header
+    size_t used;
+};
+
+/**@brief The size of the block header, the memory after it stays aligned.*/
+#define ARENA_HEADER_SIZE ARENA_ROUND(sizeof(Arena_block))
+
+/**
+ * @brief Private, allocates a block of at least size bytes after the current one.
+ */
+Arena_block *Arena_addBlock(size_t size, Arena *arena);
+
+/**
+ * @brief Creates an empty arena.
+ * @param blockSize The size of the blocks the arena gets from the heap, bigger allocations get their own block.
+ */
+Arena *Arena_new(size_t blockSize) {
+    Arena *arena = (Arena*)MT_malloc(sizeof(Arena), MT_TAG_ARENA);
+
+    arena->first = arena->current = NULL;
+    arena->last = NULL;
+    arena->blockSize = ARENA_ROUND(blockSize);
+    memset(&arena->stats, 0, sizeof(arena->stats));
+    return arena;
+}
+
+/**
+ * @brief Gives the memory of an arena back to the heap, everything allocated from it becomes invalid.
+ */
+void Arena_free(Arena *arena) {
+    Arena_block *b, *next;
+
+    if(arena == NULL)
+        return;
+
+    for(b = arena->first; b != NULL; b = next) {
+        next = b->next;
+        MT_free(b);
+    }
+    MT_free(arena);
+}
+
+/**
+ * @brief Allocates size bytes from an arena, from the heap if it is NULL.
+ */
+void *Arena_alloc(size_t size, Arena *arena) {
+    return Arena_allocTagged(size, MT_TAG_CONTAINER, arena);
+}
+
+/**
+ * @brief Allocates zeroed memory for count elements of size bytes from an arena, from the heap if it is NULL.
+ */
+void *Arena_calloc(size_t count, size_t size, Arena *arena) {
+    return Arena_callocTagged(count, size, MT_TAG_CONTAINER, arena);
+}
+
+/**
+ * @brief Resizes an allocation of an arena, or a heap allocation if the arena is NULL.
+ * @param ptr The allocation to resize, NULL to allocate a new one.
+ * @param oldSize The size ptr was allocated with.
+ * @param size The new size.
+ * @return the resized allocation, the contents are kept up to the smaller size.
+ */
+void *Arena_realloc(void *ptr, size_t oldSize, size_t size, Arena *arena) {
+    return Arena_reallocTagged(ptr, oldSize, size, MT_TAG_CONTAINER, arena);
+}
+
+/**
+ * @brief Works like Arena_alloc(), a heap allocation is tracked under the given tag.
+ */
+void *Arena_allocTagged(size_t size, MT_TAG tag, Arena *arena) {
+    Arena_block *b;
+    void *ptr;
+
+    if(arena == NULL)
+        return MT_malloc(size, tag);
+
+    size = ARENA_ROUND(size);
+    b = arena->current;
+    if(b == NULL || b->size - b->used < size) {
+        //the blocks after the current one are empty since the last reset, the first one big enough is used
+        for(b = b != NULL ? b->next : NULL; b != NULL && b->size < size; b = b->next)
+            ;
+        if(b == NULL)
+            b = Arena_addBlock(size, arena);
+        arena->current = b;
+    }
+
+    ptr = (char*)b + ARENA_HEADER_SIZE + b->used;
+    b->used += size;
+    arena->last = ptr;
+
+    arena->stats.bytes += size;
+    arena->stats.count++;
+    if(arena->stats.bytes > arena->stats.peak)
+        arena->stats.peak = arena->stats.bytes;
+    return ptr;
+}
+
+/**
+ * @brief Works like Arena_calloc(), a heap allocation is tracked under the given tag.
+ */
+void *Arena_callocTagged(size_t count, size_t size, MT_TAG tag, Arena *arena) {
+    void *ptr;
+
+    if(arena == NULL)
+        return MT_calloc(count, size, tag);
+
+    ptr = Arena_alloc(count * size, arena);
+    memset(ptr, 0, count * size);
+    return ptr;
+}
+
+/**
+ * @brief Works like Arena_realloc(), a heap allocation is tracked under the given tag.
+ */
+void *Arena_reallocTagged(void *ptr, size_t oldSize, size_t size, MT_TAG tag, Arena *arena) {
+    Arena_block *b;
+    void *newPtr;
+
+    if(arena == NULL)
+        return MT_realloc(ptr, size, tag);
+    if(ptr == NULL)
+        return Arena_alloc(size, arena);
+
+    //the latest allocation can simply be extended, if it still fits its block
+    b = arena->current;
+    oldSize = ARENA_ROUND(oldSize);
+    size = ARENA_ROUND(size);
+    if(ptr == arena->last && b->used - oldSize + size <= b->size) {
+        b->used = b->used - oldSize + size;
+        arena->stats.bytes = arena->stats.bytes - oldSize + size;
+        if(arena->stats.bytes > arena->stats.peak)
+            arena->stats.peak = arena->stats.bytes;
+        return ptr;
+    }
+    if(size <= oldSize)
+        return ptr;
+
+    newPtr = Arena_alloc(size, arena);
+    memcpy(newPtr, ptr, oldSize);
+    return newPtr;
+}
+
+/**
+ * @brief Frees a heap allocation if the arena is NULL, arena allocations are only released by Arena_reset().
+ */
+void Arena_release(void *ptr, Arena *arena) {
+    if(arena == NULL)
+        MT_free(ptr);
+}
+
+/**
+ * @brief Releases everything allocated from an arena at once, the memory is kept for the next allocations.
+ */
+void Arena_reset(Arena *arena) {
+    Arena_block *b;
+
+    for(b = arena->first; b != NULL; b = b->next) {
+#if ARENA_POISON
+        memset((char*)b + ARENA_HEADER_SIZE, ARENA_POISON_BYTE, b->used);
+#endif
+        b->used = 0;
+    }
+    arena->current = arena->first;
+    arena->last = NULL;
+    arena->stats.bytes = 0;
+    arena->stats.count = 0;
+}
+
+/**
+ * @brief Returns the allocation statistics of an arena.
+ */
+ArenaStats Arena_getStats(const Arena *arena) {
+    return arena->stats;
+}
+
+
+// private methods
+
+
+Arena_block *Arena_addBlock(size_t size, Arena *arena) {
+    Arena_block *b;
+
+    if(size < arena->blockSize)
+        size = arena->blockSize;
+    b = (Arena_block*)MT_malloc(ARENA_HEADER_SIZE + size, MT_TAG_ARENA);
+    b->size = size;
+    b->used = 0;
+
+    //link it after the current block, so the empty blocks stay behind it
+    if(arena->current == NULL) {
+        b->next = arena->first;
+        arena->first = b;
+    } else {
+        b->next = arena->current->next;
+        arena->current->next = b;
+    }
+    arena->stats.reserved += ARENA_HEADER_SIZE + size;
+    return b;
+}
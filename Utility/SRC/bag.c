@@ -19,19 +19,19 @@
 #include <string.h>
 #include "../HEAD/bag.h"
 
-/**
- * @brief The initial size of a bag.
- */
-#define BAG_INIT_SIZE (16)
 /**
  * @brief Scale at which the bag will grow if required.
  */
-#define BAG_GROW_RATE (7.0/4.0)
+#define BAG_GROW_RATE (2)
 
 /**
  * @brief Internal function to increase the size of a Bag.
  */
 void AS_grow(Bag *stack);
+/**
+ * @brief Internal function, moves the vector of a Bag into a new allocation of the given size.
+ */
+void AS_resize(int size, Bag *stack);
 
 /**
  * @brief Allocates a new Bag.
@@ -39,11 +39,35 @@ void AS_grow(Bag *stack);
  * @return the newly allocated Bag.
  */
 Bag *Bag_new(freeData freeDataPtr) {
-    Bag *stack = (Bag*)malloc(sizeof(Bag));
-    stack->vector = (void**)calloc(sizeof(void*), BAG_INIT_SIZE);
-    stack->maxSize = BAG_INIT_SIZE;
+    return Bag_newIn(freeDataPtr, NULL);
+}
+
+/**
+ * @brief Allocates a new Bag in an Arena.
+ * @param freeDataPtr a function that will be used to free held data when deleting elements.
+ * @param arena the arena the bag and its vector are allocated from, NULL for the heap.
+ * @return the newly allocated Bag.
+ */
+Bag *Bag_newIn(freeData freeDataPtr, Arena *arena) {
+    return Bag_newTagged(freeDataPtr, MT_TAG_CONTAINER, arena);
+}
+
+/**
+ * @brief Allocates a new Bag like Bag_newIn(), its heap allocations are tracked under a tag.
+ * @param freeDataPtr a function that will be used to free held data when deleting elements.
+ * @param tag the MT_TAG of the module the bag belongs to.
+ * @param arena the arena the bag and its vector are allocated from, NULL for the heap.
+ * @return the newly allocated Bag.
+ */
+Bag *Bag_newTagged(freeData freeDataPtr, MT_TAG tag, Arena *arena) {
+    Bag *stack = (Bag*)Arena_allocTagged(sizeof(Bag), tag, arena);
+    //small bags live in a single allocation
+    stack->vector = stack->inlineVector;
+    stack->maxSize = BAG_INLINE_SIZE;
     stack->elemCount = 0;
     stack->freeDataPtr = freeDataPtr;
+    stack->arena = arena;
+    stack->tag = tag;
     return stack;
 }
 
@@ -62,9 +86,10 @@ void Bag_free(struct Bag *bag, int freeDataPtr) {
         for(i = 0; i < bag->elemCount; i++)
             bag->freeDataPtr(bag->vector[i]);
 
-    //free the bag
-    free(bag->vector);
-    free(bag);
+    //free the bag, nothing to do in an arena
+    if(bag->vector != bag->inlineVector)
+        Arena_release(bag->vector, bag->arena);
+    Arena_release(bag, bag->arena);
 }
 
 /**
@@ -121,7 +146,7 @@ void Bag_slowClear(Bag *bag, int free) {
             bag->freeDataPtr(bag->vector[i]);
 
     //overwrite array with zeroes
-    memset(bag->vector, 0, bag->maxSize);
+    memset(bag->vector, 0, sizeof(void*) * bag->maxSize);
     //set elementcount to zero
     bag->elemCount = 0;
 }
@@ -133,15 +158,47 @@ void Bag_fastClear(Bag *bag) {
     bag->elemCount = 0;
 }
 
+/**
+ * @brief Makes sure the bag can hold size elements without growing.
+ */
+void Bag_reserve(int size, Bag *bag) {
+    if(size > bag->maxSize)
+        AS_resize(size, bag);
+}
+
+/**
+ * @brief Frees the unused part of the vector, moves the elements back into the Bag if they fit.
+ */
+void Bag_shrinkToFit(Bag *bag) {
+    if(bag->vector == bag->inlineVector || bag->elemCount == bag->maxSize)
+        return;
+
+    if(bag->elemCount <= BAG_INLINE_SIZE) {
+        memcpy(bag->inlineVector, bag->vector, sizeof(void*) * bag->elemCount);
+        Arena_release(bag->vector, bag->arena);
+        bag->vector = bag->inlineVector;
+        bag->maxSize = BAG_INLINE_SIZE;
+    } else {
+        AS_resize(bag->elemCount, bag);
+    }
+}
+
 
 // private methods
 
 
 void AS_grow(Bag *stack) {
-    void **newVector = (void**)malloc(sizeof(void*) * stack->maxSize * BAG_GROW_RATE);
-    memcpy(newVector, stack->vector, sizeof(void*) * stack->elemCount);
-    free(stack->vector);
+    AS_resize(stack->maxSize * BAG_GROW_RATE, stack);
+}
 
-    stack->vector = newVector;
-    stack->maxSize *= BAG_GROW_RATE;
+void AS_resize(int size, Bag *stack) {
+    //the inline vector can not be reallocated, the first allocation copies out of it
+    if(stack->vector == stack->inlineVector) {
+        stack->vector = (void**)Arena_allocTagged(sizeof(void*) * size, stack->tag, stack->arena);
+        memcpy(stack->vector, stack->inlineVector, sizeof(void*) * stack->elemCount);
+    } else {
+        stack->vector = (void**)Arena_reallocTagged(stack->vector, sizeof(void*) * stack->maxSize,
+                                                    sizeof(void*) * size, stack->tag, stack->arena);
+    }
+    stack->maxSize = size;
 }
@@ -0,0 +1,83 @@
+/*
+* Copyright (C) 2015 Bendegúz Nagy
+* 
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+* 
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+* 
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "../HEAD/frame.h"
+
+/**
+ * @brief The arena of the current frame.
+ */
+static Arena *frameArena = NULL;
+
+/**
+ * @brief Initializes the module.
+ * @param blockSize The size of the blocks the frame memory grows by, should be enough for a usual frame.
+ *
+ * It is mandatory to call this before the module is put to use in any way.
+ */
+void Frame_init(size_t blockSize)
+{
+    frameArena = Arena_new(blockSize);
+}
+
+/**
+ * @brief Deinitializes the module, the memory of the current frame becomes invalid.
+ */
+void Frame_deinit()
+{
+    Arena_free(frameArena);
+    frameArena = NULL;
+}
+
+/**
+ * @brief Allocates size bytes, valid until the next Frame_reset().
+ */
+void *Frame_alloc(size_t size)
+{
+    return Arena_alloc(size, frameArena);
+}
+
+/**
+ * @brief Allocates zeroed memory for count elements of size bytes, valid until the next Frame_reset().
+ */
+void *Frame_calloc(size_t count, size_t size)
+{
+    return Arena_calloc(count, size, frameArena);
+}
+
+/**
+ * @brief The arena of the current frame, for arrays and bags which only live until the next Frame_reset().
+ */
+Arena *Frame_arena()
+{
+    return frameArena;
+}
+
+/**
+ * @brief Releases everything allocated in the frame, called once per iteration of the main loop.
+ */
+void Frame_reset()
+{
+    Arena_reset(frameArena);
+}
+
+/**
+ * @brief Returns the allocation statistics of the frames, bytes and count are of the current frame.
+ */
+ArenaStats Frame_getStats()
+{
+    return Arena_getStats(frameArena);
+}
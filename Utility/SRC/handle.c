@@ -0,0 +1,145 @@
+/*
+* Copyright (C) 2015 Bendegúz Nagy
+* 
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+* 
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+* 
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "../HEAD/handle.h"
+
+/**@brief The nextFree of the slots in use.*/
+#define HANDLE_SLOT_USED (-2)
+
+/**
+ * @brief Private, appends a slot to the end of the free list.
+ */
+void HandleTable_pushFree(int index, HandleTable *table);
+
+/**
+ * @brief Makes an empty table on the heap.
+ */
+void HandleTable_init(HandleTable *table) {
+    HandleTable_initIn(NULL, table);
+}
+
+/**
+ * @brief Makes an empty table, the slots are allocated from an arena, or from the heap if it is NULL.
+ */
+void HandleTable_initIn(Arena *arena, HandleTable *table) {
+    HandleTable_initTagged(MT_TAG_CONTAINER, arena, table);
+}
+
+/**
+ * @brief Makes an empty table like HandleTable_initIn(), the slots on the heap are tracked under a tag.
+ */
+void HandleTable_initTagged(MT_TAG tag, Arena *arena, HandleTable *table) {
+    HandleSlotArray_initTagged(tag, arena, &table->slots);
+    table->freeHead = table->freeTail = -1;
+    table->count = 0;
+}
+
+/**
+ * @brief Frees the slots, every Handle becomes invalid.
+ */
+void HandleTable_free(HandleTable *table) {
+    HandleSlotArray_free(&table->slots);
+    table->freeHead = table->freeTail = -1;
+    table->count = 0;
+}
+
+/**
+ * @brief Stores a pointer in the table.
+ * @param ptr The pointer, can be NULL if the table is only used to track lifetimes.
+ * @return the Handle of the pointer, HANDLE_NULL if the table is full.
+ */
+Handle HandleTable_add(void *ptr, HandleTable *table) {
+    int index;
+    HandleSlot *slot;
+
+    //reuse the slot freed the longest time ago, so the generations of the slots wrap around as late as possible
+    if(table->freeHead != -1) {
+        index = table->freeHead;
+        table->freeHead = table->slots.data[index].nextFree;
+        if(table->freeHead == -1)
+            table->freeTail = -1;
+    } else {
+        if(table->slots.count == HANDLE_MAX_SLOTS)
+            return HANDLE_NULL;
+        HandleSlot fresh = {NULL, 1, -1};
+        index = HandleSlotArray_push(fresh, &table->slots);
+    }
+
+    slot = &table->slots.data[index];
+    slot->ptr = ptr;
+    slot->nextFree = HANDLE_SLOT_USED;
+    table->count++;
+    return slot->generation << HANDLE_INDEX_BITS | (uint32_t)index;
+}
+
+/**
+ * @brief Removes the pointer of a Handle, every copy of the Handle goes stale.
+ * @return non-zero if the Handle was valid.
+ */
+int HandleTable_remove(Handle handle, HandleTable *table) {
+    int index = (int)(handle & (HANDLE_MAX_SLOTS - 1));
+
+    if(!HandleTable_isValid(handle, table))
+        return 0;
+
+    HandleTable_pushFree(index, table);
+    table->count--;
+    return 1;
+}
+
+/**
+ * @brief Replaces the pointer stored for a valid Handle.
+ * @return non-zero if the Handle was valid.
+ */
+int HandleTable_set(Handle handle, void *ptr, HandleTable *table) {
+    if(!HandleTable_isValid(handle, table))
+        return 0;
+
+    table->slots.data[handle & (HANDLE_MAX_SLOTS - 1)].ptr = ptr;
+    return 1;
+}
+
+/**
+ * @brief Removes every pointer, the storage and the generations are kept, so no Handle can come back to life.
+ */
+void HandleTable_clear(HandleTable *table) {
+    int i;
+
+    for(i = 0; i < table->slots.count; i++)
+        if(table->slots.data[i].nextFree == HANDLE_SLOT_USED)
+            HandleTable_pushFree(i, table);
+    table->count = 0;
+}
+
+
+// private methods
+
+
+void HandleTable_pushFree(int index, HandleTable *table) {
+    HandleSlot *slot = &table->slots.data[index];
+
+    slot->ptr = NULL;
+    //0 is skipped, so HANDLE_NULL never matches a slot
+    slot->generation = slot->generation == HANDLE_GENERATIONS ? 1 : slot->generation + 1;
+    slot->nextFree = -1;
+
+    if(table->freeTail == -1)
+        table->freeHead = index;
+    else
+        table->slots.data[table->freeTail].nextFree = index;
+    table->freeTail = index;
+}
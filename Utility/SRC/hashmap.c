@@ -0,0 +1,193 @@
+/*
+* Copyright (C) 2015 Bendegúz Nagy
+* 
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+* 
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+* 
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../HEAD/hashmap.h"
+
+/**
+ * @brief The initial number of slots of a map, has to be a power of two.
+ */
+#define HASHMAP_INIT_SIZE (16)
+
+/**
+ * @brief Internal function, the slot a key would be stored at without collisions.
+ */
+static inline int HashMap_home(void *key, int capacity);
+/**
+ * @brief Internal function, the slot of a key, or the empty slot ending its probe sequence.
+ */
+static inline int HashMap_find(void *key, HashMap *map);
+/**
+ * @brief Internal function to double the number of slots of a HashMap.
+ */
+void HashMap_grow(HashMap *map);
+
+/**
+ * @brief Allocates a new, empty HashMap.
+ * @return the newly allocated HashMap.
+ */
+HashMap *HashMap_new() {
+    return HashMap_newIn(NULL);
+}
+
+/**
+ * @brief Allocates a new, empty HashMap in an Arena, or on the heap if it is NULL.
+ * @return the newly allocated HashMap.
+ */
+HashMap *HashMap_newIn(Arena *arena) {
+    return HashMap_newTagged(MT_TAG_CONTAINER, arena);
+}
+
+/**
+ * @brief Allocates a new, empty HashMap like HashMap_newIn(), its heap allocations are tracked under a tag.
+ * @return the newly allocated HashMap.
+ */
+HashMap *HashMap_newTagged(MT_TAG tag, Arena *arena) {
+    HashMap *map = (HashMap*)Arena_allocTagged(sizeof(HashMap), tag, arena);
+    map->entries = (HashMap_entry*)Arena_callocTagged(HASHMAP_INIT_SIZE, sizeof(HashMap_entry), tag, arena);
+    map->capacity = HASHMAP_INIT_SIZE;
+    map->elemCount = 0;
+    map->arena = arena;
+    map->tag = tag;
+    return map;
+}
+
+/**
+ * @brief Deallocate a map allocated by HashMap_new(), the keys are not touched.
+ */
+void HashMap_free(HashMap *map) {
+    if(map == NULL)
+        return;
+
+    Arena_release(map->entries, map->arena);
+    Arena_release(map, map->arena);
+}
+
+/**
+ * @brief Adds a key to the map, or updates its value if it is already there.
+ * @return non-zero if the key is new.
+ */
+int HashMap_insert(void *key, int value, HashMap *map) {
+    int i;
+
+    //keep the map at most half full, so the probe sequences stay short
+    if((map->elemCount + 1) * 2 > map->capacity)
+        HashMap_grow(map);
+
+    i = HashMap_find(key, map);
+    map->entries[i].value = value;
+    if(map->entries[i].key == key)
+        return 0;
+
+    map->entries[i].key = key;
+    map->elemCount++;
+    return 1;
+}
+
+/**
+ * @brief Looks up the value of a key.
+ * @param value set to the value of the key if it is found, can be NULL.
+ * @return non-zero if the key is in the map.
+ */
+int HashMap_get(void *key, int *value, HashMap *map) {
+    int i = HashMap_find(key, map);
+
+    if(map->entries[i].key == NULL)
+        return 0;
+
+    if(value != NULL)
+        *value = map->entries[i].value;
+    return 1;
+}
+
+/**
+ * @brief Set membership test.
+ * @return non-zero if the key is in the map.
+ */
+int HashMap_contains(void *key, HashMap *map) {
+    return map->entries[HashMap_find(key, map)].key != NULL;
+}
+
+/**
+ * @brief Removes a key from the map.
+ * @return non-zero if the key was in the map.
+ */
+int HashMap_erase(void *key, HashMap *map) {
+    int mask = map->capacity - 1;
+    int i = HashMap_find(key, map), j, home;
+
+    if(map->entries[i].key == NULL)
+        return 0;
+
+    //shift the following entries of the probe sequence back, so no tombstones are needed
+    for(j = (i + 1) & mask; map->entries[j].key != NULL; j = (j + 1) & mask) {
+        home = HashMap_home(map->entries[j].key, map->capacity);
+        //the entry can only move to i if its home is not between i and j, cyclically
+        if(((j - home) & mask) >= ((j - i) & mask)) {
+            map->entries[i] = map->entries[j];
+            i = j;
+        }
+    }
+    map->entries[i].key = NULL;
+    map->elemCount--;
+    return 1;
+}
+
+/**
+ * @brief Removes every key, the map keeps its capacity.
+ */
+void HashMap_clear(HashMap *map) {
+    if(map->elemCount != 0)
+        memset(map->entries, 0, sizeof(HashMap_entry) * map->capacity);
+    map->elemCount = 0;
+}
+
+
+// private methods
+
+
+static inline int HashMap_home(void *key, int capacity) {
+    //fibonacci hashing, the low bits of pointers are mostly zero because of alignment
+    return (int)(((uint64_t)(uintptr_t)key * 0x9E3779B97F4A7C15ull) >> 32) & (capacity - 1);
+}
+
+static inline int HashMap_find(void *key, HashMap *map) {
+    int mask = map->capacity - 1;
+    int i = HashMap_home(key, map->capacity);
+
+    while(map->entries[i].key != NULL && map->entries[i].key != key)
+        i = (i + 1) & mask;
+
+    return i;
+}
+
+void HashMap_grow(HashMap *map) {
+    int i, j;
+    HashMap_entry *old = map->entries;
+    int oldCapacity = map->capacity;
+
+    map->capacity *= 2;
+    map->entries = (HashMap_entry*)Arena_callocTagged(map->capacity, sizeof(HashMap_entry), map->tag, map->arena);
+    for(i = 0; i < oldCapacity; i++)
+        if(old[i].key != NULL) {
+            j = HashMap_find(old[i].key, map);
+            map->entries[j] = old[i];
+        }
+
+    Arena_release(old, map->arena);
+}
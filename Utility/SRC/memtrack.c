@@ -0,0 +1,224 @@
+/*
+* Copyright (C) 2015 Bendegúz Nagy
+* 
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+* 
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+* 
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdio.h>
+#include <SDL2/SDL.h>
+#include "../HEAD/memtrack.h"
+
+/**@brief The names of the tags, used by the reports.*/
+const char *mtTagNames[MT_TAG_TOTAL + 1] = {
+    "other", "containers", "arenas", "physics", "timers", "input", "graphics", "total"
+};
+
+/**@brief The statistics of each tag, the last one holds the sums of all of them.*/
+MT_Stats mtStats[MT_TAG_TOTAL + 1];
+/**@brief The statistics of each tag at the end of the last frame.*/
+MT_Stats mtFrameEnd[MT_TAG_TOTAL + 1];
+/**@brief The statistics of the last finished frame of each tag.*/
+MT_Stats mtLastFrame[MT_TAG_TOTAL + 1];
+/**@brief The most bytes allocated at once during the current frame, per tag.*/
+size_t mtFramePeak[MT_TAG_TOTAL + 1];
+/**@brief Guards all of the statistics.*/
+SDL_SpinLock mtLock = 0;
+
+#if MT_TRACKING
+
+/**
+ * @brief Internal, put in front of every tracked allocation.
+ */
+typedef struct MT_header {
+    size_t size;
+    MT_TAG tag;
+} MT_header;
+
+/**@brief The header is padded so the memory after it is as aligned as the one malloc() returns.*/
+#define MT_HEADER_SIZE ((sizeof(MT_header) + 15) & ~(size_t)15)
+#define MT_HEADER(ptr) ((MT_header*)((char*)(ptr) - MT_HEADER_SIZE))
+
+/**
+ * @brief Private, updates the statistics of a tag and the totals.
+ */
+void MT_update(MT_TAG tag, size_t added, size_t removed, int countDelta, int allocs, int frees);
+
+/**
+ * @brief Allocates tracked memory, see malloc().
+ */
+void *MT_malloc(size_t size, MT_TAG tag) {
+    MT_header *h = (MT_header*)malloc(MT_HEADER_SIZE + size);
+    if(h == NULL)
+        return NULL;
+
+    h->size = size;
+    h->tag = tag;
+    MT_update(tag, size, 0, 1, 1, 0);
+    return (char*)h + MT_HEADER_SIZE;
+}
+
+/**
+ * @brief Allocates zeroed tracked memory, see calloc().
+ */
+void *MT_calloc(size_t count, size_t size, MT_TAG tag) {
+    MT_header *h = (MT_header*)calloc(1, MT_HEADER_SIZE + count * size);
+    if(h == NULL)
+        return NULL;
+
+    h->size = count * size;
+    h->tag = tag;
+    MT_update(tag, count * size, 0, 1, 1, 0);
+    return (char*)h + MT_HEADER_SIZE;
+}
+
+/**
+ * @brief Resizes tracked memory, see realloc(). The tag is only used if ptr is NULL, resized memory keeps its tag.
+ */
+void *MT_realloc(void *ptr, size_t size, MT_TAG tag) {
+    MT_header *h;
+    size_t oldSize;
+
+    if(ptr == NULL)
+        return MT_malloc(size, tag);
+
+    oldSize = MT_HEADER(ptr)->size;
+    if((h = (MT_header*)realloc(MT_HEADER(ptr), MT_HEADER_SIZE + size)) == NULL)
+        return NULL;
+
+    h->size = size;
+    MT_update(h->tag, size, oldSize, 0, 1, 0);
+    return (char*)h + MT_HEADER_SIZE;
+}
+
+/**
+ * @brief Frees tracked memory, see free().
+ */
+void MT_free(void *ptr) {
+    MT_header *h;
+
+    if(ptr == NULL)
+        return;
+
+    h = MT_HEADER(ptr);
+    MT_update(h->tag, 0, h->size, -1, 0, 1);
+    free(h);
+}
+
+#endif
+
+/**
+ * @brief Returns the statistics of a tag since the start, MT_TAG_TOTAL returns the sums of all tags.
+ */
+MT_Stats MT_getStats(MT_TAG tag) {
+    MT_Stats s;
+    SDL_AtomicLock(&mtLock);
+    s = mtStats[tag];
+    SDL_AtomicUnlock(&mtLock);
+    return s;
+}
+
+/**
+ * @brief Returns the statistics of the last frame ended by MT_endFrame(), MT_TAG_TOTAL returns the sums of all tags.
+ */
+MT_Stats MT_getFrameStats(MT_TAG tag) {
+    MT_Stats s;
+    SDL_AtomicLock(&mtLock);
+    s = mtLastFrame[tag];
+    SDL_AtomicUnlock(&mtLock);
+    return s;
+}
+
+/**
+ * @brief Returns the name of a tag.
+ */
+const char *MT_tagName(MT_TAG tag) {
+    return mtTagNames[tag];
+}
+
+/**
+ * @brief Ends the current frame, its statistics can be queried by MT_getFrameStats() until the next call.
+ */
+void MT_endFrame() {
+    int i;
+    MT_Stats *s, *last;
+
+    SDL_AtomicLock(&mtLock);
+    for(i = 0; i <= MT_TAG_TOTAL; i++) {
+        s = &mtStats[i];
+        last = &mtLastFrame[i];
+        //the counters of the frame are the differences since the end of the previous one
+        last->live = s->live;
+        last->peak = mtFramePeak[i];
+        last->count = s->count;
+        last->allocs = s->allocs - mtFrameEnd[i].allocs;
+        last->frees = s->frees - mtFrameEnd[i].frees;
+        last->bytes = s->bytes - mtFrameEnd[i].bytes;
+        mtFrameEnd[i] = *s;
+        mtFramePeak[i] = s->live;
+    }
+    SDL_AtomicUnlock(&mtLock);
+}
+
+/**
+ * @brief Prints the allocations still alive per tag, call it when everything should have been freed.
+ * @return the number of allocations still alive, always 0 without MT_TRACKING.
+ */
+int MT_reportLeaks() {
+    MT_Stats s;
+    int i;
+
+    if(!MT_TRACKING)
+        return 0;
+
+    for(i = 0; i < MT_TAG_TOTAL; i++) {
+        s = MT_getStats((MT_TAG)i);
+        if(s.count != 0)
+            printf("MT: %d allocations, %lu bytes of %s have not been freed.\n", s.count, (unsigned long)s.live,
+                   mtTagNames[i]);
+    }
+
+    s = MT_getStats(MT_TAG_TOTAL);
+    printf("MT: %d allocations leaked, %d allocations made, peak usage %lu bytes.\n", s.count, s.allocs,
+           (unsigned long)s.peak);
+    return s.count;
+}
+
+
+//private methods
+
+
+#if MT_TRACKING
+
+void MT_update(MT_TAG tag, size_t added, size_t removed, int countDelta, int allocs, int frees) {
+    int i;
+    int tags[2] = {tag, MT_TAG_TOTAL};
+    MT_Stats *s;
+
+    SDL_AtomicLock(&mtLock);
+    for(i = 0; i < 2; i++) {
+        s = &mtStats[tags[i]];
+        s->live = s->live + added - removed;
+        s->count += countDelta;
+        s->allocs += allocs;
+        s->frees += frees;
+        s->bytes += added;
+        if(s->live > s->peak)
+            s->peak = s->live;
+        if(s->live > mtFramePeak[tags[i]])
+            mtFramePeak[tags[i]] = s->live;
+    }
+    SDL_AtomicUnlock(&mtLock);
+}
+
+#endif
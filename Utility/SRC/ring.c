@@ -0,0 +1,281 @@
+/*
+* Copyright (C) 2015 Bendegúz Nagy
+* 
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+* 
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+* 
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include "../HEAD/ring.h"
+#include "../HEAD/memtrack.h"
+
+/**
+ * @brief Private, rounds the capacity of a ring up to a power of two.
+ */
+unsigned int Ring_roundCapacity(int capacity);
+/**
+ * @brief Private, copies count elements into the ring starting at index, wrapping around the end of the buffer.
+ */
+void Ring_copyIn(const void *src, unsigned int index, unsigned int count, unsigned char *buffer, size_t elemSize,
+                 unsigned int mask);
+/**
+ * @brief Private, copies count elements out of the ring starting at index, wrapping around the end of the buffer.
+ */
+void Ring_copyOut(void *dst, unsigned int index, unsigned int count, const unsigned char *buffer, size_t elemSize,
+                  unsigned int mask);
+
+/**
+ * @brief Initializes an empty SPSCRing.
+ * @param elemSize The size of the elements in bytes.
+ * @param capacity The minimum number of elements the ring can hold, rounded up to a power of two.
+ */
+void SPSCRing_init(size_t elemSize, int capacity, SPSCRing *ring) {
+    unsigned int size = Ring_roundCapacity(capacity);
+
+    memset(ring, 0, sizeof(SPSCRing));
+    ring->buffer = (unsigned char*)MT_malloc(elemSize * size, MT_TAG_CONTAINER);
+    ring->elemSize = elemSize;
+    ring->mask = size - 1;
+    SDL_AtomicSet(&ring->tail, 0);
+    SDL_AtomicSet(&ring->head, 0);
+}
+
+/**
+ * @brief Frees the buffer of an SPSCRing, neither side may use it anymore.
+ */
+void SPSCRing_free(SPSCRing *ring) {
+    MT_free(ring->buffer);
+    ring->buffer = NULL;
+}
+
+/**
+ * @brief Pushes an element, producer side.
+ * @return non-zero if the ring is full.
+ */
+int SPSCRing_push(const void *elem, SPSCRing *ring) {
+    return SPSCRing_pushN(elem, 1, ring) == 1 ? 0 : -1;
+}
+
+/**
+ * @brief Pushes as many elements of an array as there is room for, producer side.
+ * @return the number of elements pushed, the first ones of the array.
+ */
+int SPSCRing_pushN(const void *elems, int count, SPSCRing *ring) {
+    unsigned int tail = (unsigned int)SDL_AtomicGet(&ring->tail);
+    unsigned int room = ring->mask + 1 - (tail - ring->headCache);
+    unsigned int n;
+
+    if(count <= 0)
+        return 0;
+
+    //only look at the consumer's index if our copy says there is not enough room
+    if(room < (unsigned int)count) {
+        ring->headCache = (unsigned int)SDL_AtomicGet(&ring->head);
+        room = ring->mask + 1 - (tail - ring->headCache);
+    }
+    n = room < (unsigned int)count ? room : (unsigned int)count;
+    if(n == 0)
+        return 0;
+
+    Ring_copyIn(elems, tail, n, ring->buffer, ring->elemSize, ring->mask);
+    //the elements have to be written before the consumer can see the new tail
+    SDL_MemoryBarrierRelease();
+    SDL_AtomicSet(&ring->tail, (int)(tail + n));
+    return (int)n;
+}
+
+/**
+ * @brief Pops the oldest element, consumer side.
+ * @param elem Where the element is copied.
+ * @return non-zero if the ring is empty.
+ */
+int SPSCRing_pop(void *elem, SPSCRing *ring) {
+    return SPSCRing_popN(elem, 1, ring) == 1 ? 0 : -1;
+}
+
+/**
+ * @brief Pops at most count elements into an array, consumer side.
+ * @return the number of elements popped.
+ */
+int SPSCRing_popN(void *elems, int count, SPSCRing *ring) {
+    unsigned int head = (unsigned int)SDL_AtomicGet(&ring->head);
+    unsigned int avail = ring->tailCache - head;
+    unsigned int n;
+
+    if(count <= 0)
+        return 0;
+
+    //only look at the producer's index if our copy says there are not enough elements
+    if(avail < (unsigned int)count) {
+        ring->tailCache = (unsigned int)SDL_AtomicGet(&ring->tail);
+        avail = ring->tailCache - head;
+    }
+    n = avail < (unsigned int)count ? avail : (unsigned int)count;
+    if(n == 0)
+        return 0;
+
+    //the producer has written the elements before moving the tail
+    SDL_MemoryBarrierAcquire();
+    Ring_copyOut(elems, head, n, ring->buffer, ring->elemSize, ring->mask);
+    //hand the slots back to the producer, only after they have been read
+    SDL_MemoryBarrierRelease();
+    SDL_AtomicSet(&ring->head, (int)(head + n));
+    return (int)n;
+}
+
+/**
+ * @brief Returns the number of elements in the ring, it can be out of date by the time it returns.
+ */
+int SPSCRing_count(SPSCRing *ring) {
+    unsigned int head = (unsigned int)SDL_AtomicGet(&ring->head);
+    return (int)((unsigned int)SDL_AtomicGet(&ring->tail) - head);
+}
+
+/**
+ * @brief Initializes an empty MPSCRing.
+ * @param elemSize The size of the elements in bytes.
+ * @param capacity The minimum number of elements the ring can hold, rounded up to a power of two.
+ */
+void MPSCRing_init(size_t elemSize, int capacity, MPSCRing *ring) {
+    unsigned int size = Ring_roundCapacity(capacity);
+
+    memset(ring, 0, sizeof(MPSCRing));
+    ring->buffer = (unsigned char*)MT_malloc(elemSize * size, MT_TAG_CONTAINER);
+    //no slot is ready, the first element expected in slot i has index i and 0 is only ever expected after 2^32 pushes
+    ring->ready = (SDL_atomic_t*)MT_calloc(size, sizeof(SDL_atomic_t), MT_TAG_CONTAINER);
+    ring->elemSize = elemSize;
+    ring->mask = size - 1;
+    SDL_AtomicSet(&ring->tail, 0);
+    SDL_AtomicSet(&ring->head, 0);
+}
+
+/**
+ * @brief Frees the buffers of an MPSCRing, no thread may use it anymore.
+ */
+void MPSCRing_free(MPSCRing *ring) {
+    MT_free(ring->buffer);
+    MT_free(ring->ready);
+    ring->buffer = NULL;
+    ring->ready = NULL;
+}
+
+/**
+ * @brief Pushes an element, can be called from any thread.
+ * @return non-zero if the ring is full.
+ */
+int MPSCRing_push(const void *elem, MPSCRing *ring) {
+    return MPSCRing_pushN(elem, 1, ring) == 1 ? 0 : -1;
+}
+
+/**
+ * @brief Pushes as many elements of an array as there is room for, can be called from any thread.
+ *
+ * The pushed elements stay together, the ones of other producers are either before or after them.
+ * @return the number of elements pushed, the first ones of the array.
+ */
+int MPSCRing_pushN(const void *elems, int count, MPSCRing *ring) {
+    unsigned int tail, room, n, i;
+
+    if(count <= 0)
+        return 0;
+
+    //claim the slots, the ones before the head have been copied out by the consumer
+    do {
+        tail = (unsigned int)SDL_AtomicGet(&ring->tail);
+        room = ring->mask + 1 - (tail - (unsigned int)SDL_AtomicGet(&ring->head));
+        n = room < (unsigned int)count ? room : (unsigned int)count;
+        if(n == 0)
+            return 0;
+    } while(!SDL_AtomicCAS(&ring->tail, (int)tail, (int)(tail + n)));
+
+    Ring_copyIn(elems, tail, n, ring->buffer, ring->elemSize, ring->mask);
+    //the elements have to be written before the consumer can see them ready
+    SDL_MemoryBarrierRelease();
+    for(i = 0; i < n; i++)
+        SDL_AtomicSet(&ring->ready[(tail + i) & ring->mask], (int)(tail + i + 1));
+    return (int)n;
+}
+
+/**
+ * @brief Pops the oldest element, consumer side.
+ * @param elem Where the element is copied.
+ * @return non-zero if the ring is empty, or the oldest element is still being written.
+ */
+int MPSCRing_pop(void *elem, MPSCRing *ring) {
+    return MPSCRing_popN(elem, 1, ring) == 1 ? 0 : -1;
+}
+
+/**
+ * @brief Pops at most count elements into an array, consumer side, stops at the first element still being written.
+ * @return the number of elements popped.
+ */
+int MPSCRing_popN(void *elems, int count, MPSCRing *ring) {
+    unsigned int head = (unsigned int)SDL_AtomicGet(&ring->head);
+    unsigned int n = 0;
+
+    while(n < (unsigned int)count && (unsigned int)SDL_AtomicGet(&ring->ready[(head + n) & ring->mask]) == head + n + 1)
+        n++;
+    if(n == 0)
+        return 0;
+
+    //the producers have written the elements before marking them ready
+    SDL_MemoryBarrierAcquire();
+    Ring_copyOut(elems, head, n, ring->buffer, ring->elemSize, ring->mask);
+    //hand the slots back to the producers, only after they have been read
+    SDL_MemoryBarrierRelease();
+    SDL_AtomicSet(&ring->head, (int)(head + n));
+    return (int)n;
+}
+
+/**
+ * @brief Returns the number of claimed slots, including the ones still being written, it can be out of date by the
+ * time it returns.
+ */
+int MPSCRing_count(MPSCRing *ring) {
+    unsigned int head = (unsigned int)SDL_AtomicGet(&ring->head);
+    return (int)((unsigned int)SDL_AtomicGet(&ring->tail) - head);
+}
+
+
+// private methods
+
+
+unsigned int Ring_roundCapacity(int capacity) {
+    unsigned int size = 1;
+    while(size < (unsigned int)capacity)
+        size <<= 1;
+    return size;
+}
+
+void Ring_copyIn(const void *src, unsigned int index, unsigned int count, unsigned char *buffer, size_t elemSize,
+                 unsigned int mask) {
+    unsigned int start = index & mask;
+    unsigned int first = mask + 1 - start; //slots until the end of the buffer
+
+    if(first > count)
+        first = count;
+    memcpy(buffer + start * elemSize, src, first * elemSize);
+    memcpy(buffer, (const unsigned char*)src + first * elemSize, (count - first) * elemSize);
+}
+
+void Ring_copyOut(void *dst, unsigned int index, unsigned int count, const unsigned char *buffer, size_t elemSize,
+                  unsigned int mask) {
+    unsigned int start = index & mask;
+    unsigned int first = mask + 1 - start; //slots until the end of the buffer
+
+    if(first > count)
+        first = count;
+    memcpy(dst, buffer + start * elemSize, first * elemSize);
+    memcpy((unsigned char*)dst + first * elemSize, buffer, (count - first) * elemSize);
+}
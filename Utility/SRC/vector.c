@@ -16,93 +16,93 @@
 */
 
 #include "../HEAD/vector.h"
+#include "../HEAD/memtrack.h"
 #include <stdlib.h>
 #include <math.h>
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE__)
+#include <xmmintrin.h>
+#endif
 
 Vector2D *VEC2D_new(float x, float y) {
-    Vector2D *ptr = (Vector2D *) malloc(sizeof(Vector2D));
+    Vector2D *ptr = (Vector2D *) MT_malloc(sizeof(Vector2D), MT_TAG_OTHER);
     ptr->x = x;
     ptr->y = y;
     return ptr;
 }
 
 Vector2D *VEC2D_Pnew(float angle, float length) {
-    Vector2D *ptr = (Vector2D *) malloc(sizeof(Vector2D));
-    ptr->x = cosf(angle) * length;
-    ptr->y = sinf(angle) * length;
+    Vector2D *ptr = (Vector2D *) MT_malloc(sizeof(Vector2D), MT_TAG_OTHER);
+    float s, c;
+    FM_sincos(angle, &s, &c);
+    ptr->x = c * length;
+    ptr->y = s * length;
     return ptr;
 }
 
 
 void VEC2D_free(Vector2D *ptr) {
-    free(ptr);
+    MT_free(ptr);
 }
 
-
-Vector2D VEC2D_add(const Vector2D *srcA, const Vector2D *srcB) {
-    Vector2D vec = {
-            srcA->x + srcB->x,
-            srcA->y + srcB->y
-    };
-    return vec;
-}
-
-Vector2D VEC2D_sub(const Vector2D *srcA, const Vector2D *srcB) {
-    Vector2D vec = {
-            srcA->x - srcB->x,
-            srcA->y - srcB->y
-    };
-    return vec;
-}
-
-Vector2D VEC2D_scale(Vector2D *srcA, float scale) {
-    Vector2D vec = {
-            srcA->x * scale,
-            srcA->y * scale
-    };
-    return vec;
-}
-
-Vector2D VEC2D_rotate(Vector2D *srcA, float angle) {
-    float x = srcA->x, y = srcA->y;
-    Vector2D vec = {
-            x * cosf(angle) - y * sinf(angle),
-            x * sinf(angle) + y * cosf(angle)
-    };
-    return vec;
-}
-
-Vector2D VEC2D_normalize(Vector2D *srcA) {
-    float length = VEC2D_length(srcA);
-    return VEC2D_scale(srcA, 1.0 / length);
-}
-
-
-Vector2D VEC2d_integrate(Vector2D *srcA, Vector2D *srcInteg, float scale) {
-    Vector2D vec = {
-            srcA->x + srcInteg->x * scale,
-            srcA->y + srcInteg->y * scale
-    };
-    return vec;
-}
-
-float VEC2D_distance(Vector2D *a, Vector2D *b) {
-    Vector2D tmp = VEC2D_sub(a, b);
-    return VEC2D_length(&tmp);
-}
-
-float VEC2D_scalar(Vector2D *a, Vector2D *b) {
-    return a->x * b->x + a->y * b->y;
-}
-
-float VEC2D_angle(Vector2D *src) {
-    return atan(src->y / src->x);
+/*
+ * The batched functions treat the vectors as an array of 2n floats, x and y are processed the same way. The unaligned
+ * loads and stores cost the same as the aligned ones on anything with AVX, arrays of Vector2Ds are only 8 byte aligned.
+ */
+
+void VEC2D_addN(Vector2D *dst, const Vector2D *a, const Vector2D *b, int n) {
+    float *d = (float*)dst;
+    const float *fa = (const float*)a, *fb = (const float*)b;
+    int i = 0, count = n * 2;
+
+#if defined(__AVX__)
+    for(; i + 8 <= count; i += 8)
+        _mm256_storeu_ps(d + i, _mm256_add_ps(_mm256_loadu_ps(fa + i), _mm256_loadu_ps(fb + i)));
+#endif
+#if defined(__SSE__)
+    for(; i + 4 <= count; i += 4)
+        _mm_storeu_ps(d + i, _mm_add_ps(_mm_loadu_ps(fa + i), _mm_loadu_ps(fb + i)));
+#endif
+    for(; i < count; i++)
+        d[i] = fa[i] + fb[i];
 }
 
-float VEC2D_length(Vector2D *src) {
-    return sqrt(src->x * src->x + src->y * src->y);
+void VEC2D_scaleN(Vector2D *dst, const Vector2D *src, float scale, int n) {
+    float *d = (float*)dst;
+    const float *fs = (const float*)src;
+    int i = 0, count = n * 2;
+
+#if defined(__AVX__)
+    __m256 s8 = _mm256_set1_ps(scale);
+    for(; i + 8 <= count; i += 8)
+        _mm256_storeu_ps(d + i, _mm256_mul_ps(_mm256_loadu_ps(fs + i), s8));
+#endif
+#if defined(__SSE__)
+    __m128 s4 = _mm_set1_ps(scale);
+    for(; i + 4 <= count; i += 4)
+        _mm_storeu_ps(d + i, _mm_mul_ps(_mm_loadu_ps(fs + i), s4));
+#endif
+    for(; i < count; i++)
+        d[i] = fs[i] * scale;
 }
 
-float VEC2d_lSquared(Vector2D *src) {
-    return src->x * src->x + src->y * src->y;
+void VEC2D_integrateN(Vector2D *dst, const Vector2D *src, float scale, int n) {
+    float *d = (float*)dst;
+    const float *fs = (const float*)src;
+    int i = 0, count = n * 2;
+
+    //no fused multiply-add, so the results are the same as VEC2D_integrate()'s on every path
+#if defined(__AVX__)
+    __m256 s8 = _mm256_set1_ps(scale);
+    for(; i + 8 <= count; i += 8)
+        _mm256_storeu_ps(d + i, _mm256_add_ps(_mm256_loadu_ps(d + i), _mm256_mul_ps(_mm256_loadu_ps(fs + i), s8)));
+#endif
+#if defined(__SSE__)
+    __m128 s4 = _mm_set1_ps(scale);
+    for(; i + 4 <= count; i += 4)
+        _mm_storeu_ps(d + i, _mm_add_ps(_mm_loadu_ps(d + i), _mm_mul_ps(_mm_loadu_ps(fs + i), s4)));
+#endif
+    for(; i < count; i++)
+        d[i] = d[i] + fs[i] * scale;
 }